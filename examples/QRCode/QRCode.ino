@@ -3,14 +3,19 @@
  *
  *  A quick example of generating a QR code.
  *
- *  This prints the QR code to the serial monitor as solid blocks. Each module
- *  is two characters wide, since the monospace font used in the serial monitor
- *  is approximately twice as tall as wide.
+ *  This prints the QR code to the serial monitor with half block characters.
+ *  Each character holds two modules, one above the other, since the monospace
+ *  font used in the serial monitor is approximately twice as tall as wide.
  *
  */
 
 #include "qrcode.h"
 
+// Send text from qrcode_writeText() to the serial port
+static bool serial_cb(void *ctx, const uint8_t *data, size_t length) {
+    return Serial.write(data, length) == length;
+}
+
 void setup() {
     Serial.begin(115200);
 
@@ -28,27 +33,8 @@ void setup() {
     Serial.print(dt);
     Serial.print("\n");
 
-    // Top quiet zone
-    Serial.print("\n\n\n\n");
-
-    for (uint8_t y = 0; y < qrcode.size; y++) {
-
-        // Left quiet zone
-        Serial.print("        ");
-
-        // Each horizontal module
-        for (uint8_t x = 0; x < qrcode.size; x++) {
-
-            // Print each module (UTF-8 \u2588 is a solid block)
-            Serial.print(qrcode_getModule(&qrcode, x, y) ? "\u2588\u2588": "  ");
-
-        }
-
-        Serial.print("\n");
-    }
-
-    // Bottom quiet zone
-    Serial.print("\n\n\n\n");
+    // Print the QR code with a 4 module quiet zone
+    qrcode_writeText(&qrcode, 0, 4, serial_cb, NULL);
 }
 
 void loop() {
@@ -383,6 +383,31 @@ static void drawVersion(BitBucket *modules, BitBucket *isFunction, uint8_t versi
 #endif
 }
 
+// Stores the row/column coordinates of the alignment pattern centers in ascending order and
+// returns how many there are (0 for version 1, at most 7).
+static uint8_t getAlignmentPositions(uint8_t version, uint8_t *alignPosition) {
+    if (version < 2) { return 0; }
+
+    uint8_t alignCount = version / 7 + 2;
+    uint8_t step;
+    if (version != 32) {
+        step = (version * 4 + alignCount * 2 + 1) / (2 * alignCount - 2) * 2;  // ceil((size - 13) / (2*numAlign - 2)) * 2
+    } else { // C-C-C-Combo breaker!
+        step = 26;
+    }
+
+    uint8_t alignPositionIndex = alignCount - 1;
+
+    alignPosition[0] = 6;
+
+    uint8_t size = version * 4 + 17;
+    for (uint8_t i = 0, pos = size - 7; i < alignCount - 1; i++, pos -= step) {
+        alignPosition[alignPositionIndex--] = pos;
+    }
+
+    return alignCount;
+}
+
 static void drawFunctionPatterns(BitBucket *modules, BitBucket *isFunction, uint8_t version, uint8_t ecc) {
 
     uint8_t size = modules->bitOffsetOrWidth;
@@ -400,35 +425,16 @@ static void drawFunctionPatterns(BitBucket *modules, BitBucket *isFunction, uint
 
 #if LOCK_VERSION == 0 || LOCK_VERSION > 1
 
-    if (version > 1) {
-
-        // Draw the numerous alignment patterns
-
-        uint8_t alignCount = version / 7 + 2;
-        uint8_t step;
-        if (version != 32) {
-            step = (version * 4 + alignCount * 2 + 1) / (2 * alignCount - 2) * 2;  // ceil((size - 13) / (2*numAlign - 2)) * 2
-        } else { // C-C-C-Combo breaker!
-            step = 26;
-        }
-
-        uint8_t alignPositionIndex = alignCount - 1;
-        uint8_t alignPosition[alignCount];
-
-        alignPosition[0] = 6;
+    // Draw the numerous alignment patterns
+    uint8_t alignPosition[7];
+    uint8_t alignCount = getAlignmentPositions(version, alignPosition);
 
-        uint8_t size = version * 4 + 17;
-        for (uint8_t i = 0, pos = size - 7; i < alignCount - 1; i++, pos -= step) {
-            alignPosition[alignPositionIndex--] = pos;
-        }
-
-        for (uint8_t i = 0; i < alignCount; i++) {
-            for (uint8_t j = 0; j < alignCount; j++) {
-                if ((i == 0 && j == 0) || (i == 0 && j == alignCount - 1) || (i == alignCount - 1 && j == 0)) {
-                    continue;  // Skip the three finder corners
-                } else {
-                    drawAlignmentPattern(modules, isFunction, alignPosition[i], alignPosition[j]);
-                }
+    for (uint8_t i = 0; i < alignCount; i++) {
+        for (uint8_t j = 0; j < alignCount; j++) {
+            if ((i == 0 && j == 0) || (i == 0 && j == alignCount - 1) || (i == alignCount - 1 && j == 0)) {
+                continue;  // Skip the three finder corners
+            } else {
+                drawAlignmentPattern(modules, isFunction, alignPosition[i], alignPosition[j]);
             }
         }
     }
@@ -475,106 +481,6 @@ static void drawCodewords(BitBucket *modules, BitBucket *isFunction, BitBucket *
 
 
 
-#pragma mark - Penalty Calculation
-
-#define PENALTY_N1      3
-#define PENALTY_N2      3
-#define PENALTY_N3     40
-#define PENALTY_N4     10
-
-// Calculates and returns the penalty score based on state of this QR Code's current modules.
-// This is used by the automatic mask choice algorithm to find the mask pattern that yields the lowest score.
-// @TODO: This can be optimized by working with the bytes instead of bits.
-static uint32_t getPenaltyScore(BitBucket *modules) {
-    uint32_t result = 0;
-
-    uint8_t size = modules->bitOffsetOrWidth;
-
-    // Adjacent modules in row having same color
-    for (uint8_t y = 0; y < size; y++) {
-
-        bool colorX = bb_getBit(modules, 0, y);
-        for (uint8_t x = 1, runX = 1; x < size; x++) {
-            bool cx = bb_getBit(modules, x, y);
-            if (cx != colorX) {
-                colorX = cx;
-                runX = 1;
-
-            } else {
-                runX++;
-                if (runX == 5) {
-                    result += PENALTY_N1;
-                } else if (runX > 5) {
-                    result++;
-                }
-            }
-        }
-    }
-
-    // Adjacent modules in column having same color
-    for (uint8_t x = 0; x < size; x++) {
-        bool colorY = bb_getBit(modules, x, 0);
-        for (uint8_t y = 1, runY = 1; y < size; y++) {
-            bool cy = bb_getBit(modules, x, y);
-            if (cy != colorY) {
-                colorY = cy;
-                runY = 1;
-            } else {
-                runY++;
-                if (runY == 5) {
-                    result += PENALTY_N1;
-                } else if (runY > 5) {
-                    result++;
-                }
-            }
-        }
-    }
-
-    uint16_t black = 0;
-    for (uint8_t y = 0; y < size; y++) {
-        uint16_t bitsRow = 0, bitsCol = 0;
-        for (uint8_t x = 0; x < size; x++) {
-            bool color = bb_getBit(modules, x, y);
-
-            // 2*2 blocks of modules having same color
-            if (x > 0 && y > 0) {
-                bool colorUL = bb_getBit(modules, x - 1, y - 1);
-                bool colorUR = bb_getBit(modules, x, y - 1);
-                bool colorL = bb_getBit(modules, x - 1, y);
-                if (color == colorUL && color == colorUR && color == colorL) {
-                    result += PENALTY_N2;
-                }
-            }
-
-            // Finder-like pattern in rows and columns
-            bitsRow = ((bitsRow << 1) & 0x7FF) | color;
-            bitsCol = ((bitsCol << 1) & 0x7FF) | bb_getBit(modules, y, x);
-
-            // Needs 11 bits accumulated
-            if (x >= 10) {
-                if (bitsRow == 0x05D || bitsRow == 0x5D0) {
-                    result += PENALTY_N3;
-                }
-                if (bitsCol == 0x05D || bitsCol == 0x5D0) {
-                    result += PENALTY_N3;
-                }
-            }
-
-            // Balance of black and white modules
-            if (color) { black++; }
-        }
-    }
-
-    // Find smallest k such that (45-5k)% <= dark/total <= (55+5k)%
-    uint16_t total = size * size;
-    for (uint16_t k = 0; black * 20 < (9 - k) * total || black * 20 > (11 + k) * total; k++) {
-        result += PENALTY_N4;
-    }
-
-    return result;
-}
-
-
 #pragma mark - Reed-Solomon Generator
 
 static uint8_t rs_multiply(uint8_t x, uint8_t y) {
@@ -770,12 +676,347 @@ static void performErrorCorrection(uint8_t version, uint8_t ecc, BitBucket *data
 static const uint8_t ECC_FORMAT_BITS = (0x02 << 6) | (0x03 << 4) | (0x00 << 2) | (0x01 << 0);
 
 
+#pragma mark - Row words
+
+// Rows of modules are handled 32 at a time as words, with the leftmost module in the most
+// significant bit.  A row of the largest symbol (177 modules) fits in 6 words.
+#define ROW_WORDS(size)     (((size) + 31) / 32)
+
+static uint8_t countLeadingZeros(uint32_t word) {
+#if defined(__GNUC__)
+    return word ? (uint8_t)__builtin_clz(word) : 32;
+#else
+    uint8_t count = 0;
+    if (!word) { return 32; }
+    while (!(word & 0x80000000)) {
+        word <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+static uint8_t countBits(uint32_t word) {
+#if defined(__GNUC__)
+    return (uint8_t)__builtin_popcount(word);
+#else
+    uint8_t count = 0;
+    for (; word; word &= word - 1) { count++; }
+    return count;
+#endif
+}
+
+// Returns the bit offset of module (x, y) in either layout.
+static uint32_t getModuleOffset(QRCode *qrcode, uint8_t x, uint8_t y) {
+    return (uint32_t)y * (qrcode->stride ? qrcode->stride * 8 : qrcode->size) + x;
+}
+
+// Returns the number of bytes used in the modules buffer.
+static uint16_t getModuleBytes(QRCode *qrcode) {
+    return qrcode->stride ? qrcode->size * qrcode->stride : bb_getGridSizeBytes(qrcode->size);
+}
+
+// Returns the 32 modules of row y starting at column x; modules past the end of the row are 0.
+static uint32_t getRowWord(QRCode *qrcode, uint8_t y, uint8_t x) {
+    uint8_t size = qrcode->size;
+    if (x >= size) { return 0; }
+
+    uint32_t offset = getModuleOffset(qrcode, x, y);
+    uint16_t index = offset >> 3, count = getModuleBytes(qrcode);
+    uint64_t bits = 0;
+
+    // Gather 40 bits, enough for 32 at any bit offset...
+    for (uint8_t i = 0; i < 5; i++) {
+        bits = (bits << 8) | (index + i < count ? qrcode->modules[index + i] : 0);
+    }
+
+    uint32_t word = (uint32_t)(bits >> (8 - (offset & 7)));
+    if (size - x < 32) { word &= ~(0xffffffffu >> (size - x)); }
+    return word;
+}
+
+// Copies row y into words with a funnel shift over the bytes holding it.
+static void getRowWords(QRCode *qrcode, uint8_t y, uint32_t *words) {
+    uint8_t size = qrcode->size;
+    uint32_t offset = getModuleOffset(qrcode, 0, y);
+    const uint8_t *src = qrcode->modules + (offset >> 3);
+    uint8_t shift = offset & 7, count = (shift + size + 7) / 8;
+
+    for (uint8_t i = 0; i < ROW_WORDS(size); i++) {
+        uint64_t bits = 0;
+        for (uint8_t j = 4 * i; j < 4 * i + 5; j++) { bits = (bits << 8) | (j < count ? src[j] : 0); }
+        words[i] = (uint32_t)(bits >> (8 - shift));
+    }
+    if (size % 32) { words[size / 32] &= ~(0xffffffffu >> (size % 32)); }
+}
+
+// Reverses the bits in each byte of a word.
+static uint32_t reverseByteBits(uint32_t word) {
+    word = ((word >> 1) & 0x55555555u) | ((word & 0x55555555u) << 1);
+    word = ((word >> 2) & 0x33333333u) | ((word & 0x33333333u) << 2);
+    return ((word >> 4) & 0x0f0f0f0fu) | ((word & 0x0f0f0f0fu) << 4);
+}
+
+// Reverses the bits of a word.
+static uint32_t reverseBits(uint32_t word) {
+    word = reverseByteBits(word);
+    return word >> 24 | ((word >> 8) & 0xff00) | ((word << 8) & 0xff0000) | word << 24;
+}
+
+// Returns a mask of the bits of word "i" that are in columns [x, x + width).
+static uint32_t rowMask(uint8_t i, uint16_t x, uint16_t width) {
+    int16_t start = x - i * 32, end = x + width - i * 32;
+    if (start < 0) { start = 0; }
+    if (end > 32) { end = 32; }
+    if (start >= end) { return 0; }
+    return (0xffffffffu >> start) & ~(end == 32 ? 0 : 0xffffffffu >> end);
+}
+
+// Returns the column of the first set module at or after x, or "size" if there is none.
+static uint8_t rowFindSet(const uint32_t *words, uint8_t size, uint8_t x) {
+    for (uint8_t i = x / 32; i < ROW_WORDS(size); i++) {
+        uint32_t word = words[i] & rowMask(i, x, size - x);
+        if (word) { return i * 32 + countLeadingZeros(word); }
+    }
+    return size;
+}
+
+// Returns the number of consecutive set modules starting at column x.
+static uint8_t rowRunLength(const uint32_t *words, uint8_t size, uint8_t x) {
+    for (uint8_t i = x / 32; i < ROW_WORDS(size); i++) {
+        uint32_t word = ~words[i] & rowMask(i, x, size - x);
+        if (word) { return i * 32 + countLeadingZeros(word) - x; }
+    }
+    return size - x;
+}
+
+// Gathers column x into words, with the top module in the most significant bit.
+static void getColumnWords(QRCode *qrcode, uint8_t x, uint32_t *words) {
+    uint8_t size = qrcode->size;
+    uint32_t offset = x, step = getModuleOffset(qrcode, 0, 1);
+
+    memset(words, 0, ROW_WORDS(size) * sizeof(uint32_t));
+    for (uint8_t y = 0; y < size; y++, offset += step) {
+        if (qrcode->modules[offset >> 3] & (128 >> (offset & 7))) { words[y / 32] |= 0x80000000u >> (y % 32); }
+    }
+}
+
+
+// Transposes an 8x8 bit matrix held with row 0 in the most significant byte and column 0 in
+// the most significant bit of each row (Hacker's Delight, 7-3).
+static uint64_t transpose8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+    return x ^ t ^ (t << 28);
+}
+
+// Stores the top "count" bits of "bits" as the modules of row y from column x.
+static void setRowBits(QRCode *qrcode, uint8_t x, uint8_t y, uint8_t bits, uint8_t count) {
+    uint32_t offset = getModuleOffset(qrcode, x, y);
+    uint8_t *dst = qrcode->modules + (offset >> 3);
+    uint8_t shift = offset & 7;
+    uint16_t mask = (uint16_t)(0xff00u << (8 - count)) >> shift, value = (uint16_t)(bits << 8) >> shift;
+
+    dst[0] = (uint8_t)((dst[0] & ~(mask >> 8)) | ((value & mask) >> 8));
+    if (mask & 0xff) { dst[1] = (uint8_t)((dst[1] & ~mask) | (value & mask)); }
+}
+
+static void setRowWords(QRCode *qrcode, uint8_t y, const uint32_t *words) {
+    for (uint8_t x = 0; x < qrcode->size; x += 8) {
+        uint8_t count = qrcode->size - x < 8 ? qrcode->size - x : 8;
+        setRowBits(qrcode, x, y, (uint8_t)(words[x / 32] >> (24 - x % 32)), count);
+    }
+}
+
+// Returns the 8x8 block of modules with its top-left corner at (x, y); modules outside the
+// symbol are 0.
+static uint64_t getBlock(QRCode *qrcode, uint8_t x, uint8_t y) {
+    uint64_t block = 0;
+    for (uint8_t r = 0; r < 8; r++) {
+        block = (block << 8) | (y + r < qrcode->size ? getRowWord(qrcode, y + r, x) >> 24 : 0);
+    }
+    return block;
+}
+
+// Stores the part of an 8x8 block that is inside the symbol.
+static void setBlock(QRCode *qrcode, uint8_t x, uint8_t y, uint64_t block) {
+    uint8_t count = qrcode->size - x < 8 ? qrcode->size - x : 8;
+    for (uint8_t r = 0; r < 8 && y + r < qrcode->size; r++) {
+        setRowBits(qrcode, x, y + r, (uint8_t)(block >> (56 - 8 * r)), count);
+    }
+}
+
+
+// Returns the module in quadrant q (0 = NW, 1 = NE, 2 = SE, 3 = SW) of the corner (x, y);
+// corners run from 0 to size, and modules outside the symbol are light.
+static bool getCornerModule(QRCode *qrcode, uint8_t x, uint8_t y, uint8_t q) {
+    int16_t mx = (q == 1 || q == 2) ? x : x - 1;
+    int16_t my = (q >= 2) ? y : y - 1;
+    if (mx < 0 || my < 0) { return false; }
+    return qrcode_getModule(qrcode, mx, my);
+}
+
+// Moves the rows of a newly drawn symbol onto byte boundaries, in place.  Working back from
+// the last byte, every source byte is read before it is overwritten.
+static void alignModuleRows(QRCode *qrcode) {
+    uint8_t size = qrcode->size, stride = (size + 7) / 8;
+    uint8_t *modules = qrcode->modules;
+    uint16_t count = bb_getGridSizeBytes(size);
+
+    for (int16_t y = size - 1; y >= 0; y--) {
+        uint32_t offset = (uint32_t)y * size;
+        uint16_t index = offset >> 3;
+        uint8_t shift = offset & 7;
+
+        for (int16_t i = stride - 1; i >= 0; i--) {
+            uint8_t next = shift && index + i + 1 < count ? modules[index + i + 1] : 0;
+            uint8_t byte = (uint8_t)(modules[index + i] << shift | next >> (8 - shift));
+
+            if (i == stride - 1 && size % 8) { byte &= (uint8_t)(0xff00 >> (size % 8)); }
+            modules[y * stride + i] = byte;
+        }
+    }
+
+    qrcode->stride = stride;
+}
+
+
+#pragma mark - Penalty Calculation
+
+#define PENALTY_N1      3
+#define PENALTY_N2      3
+#define PENALTY_N3     40
+#define PENALTY_N4     10
+
+// Returns the penalty for a run of modules of the same color.
+static uint32_t getRunPenalty(uint8_t length) {
+    return length >= 5 ? PENALTY_N1 + length - 5 : 0;
+}
+
+// Returns the 32 modules of a line of words starting at column p.
+static uint32_t getLineBits(const uint32_t *line, uint8_t words, uint16_t p) {
+    uint8_t i = p / 32, shift = p % 32;
+    if (i >= words) { return 0; }
+    return shift && i + 1 < words ? line[i] << shift | line[i + 1] >> (32 - shift) : line[i] << shift;
+}
+
+// Calculates the penalties for runs and finder-like patterns along one row (or transposed
+// column) of modules.
+static uint32_t getLinePenalty(const uint32_t *line, uint8_t size) {
+    uint8_t words = ROW_WORDS(size), start = 0;
+    uint32_t result = 0;
+
+    // Runs of the same color end where bit x differs from bit x - 1...
+    for (uint8_t i = 0; i < words; i++) {
+        uint32_t previous = line[i] >> 1 | (i > 0 ? line[i - 1] << 31 : 0);
+        uint32_t changes = (line[i] ^ previous) & rowMask(i, 1, size - 1);
+
+        while (changes) {
+            uint8_t bit = countLeadingZeros(changes);
+            result += getRunPenalty(i * 32 + bit - start);
+            start = i * 32 + bit;
+            changes &= ~(0x80000000u >> bit);
+        }
+    }
+    result += getRunPenalty(size - start);
+
+    // Finder-like patterns (1:1:3:1:1 with 4 light modules on one side), matched at 32
+    // starting columns at once
+    for (uint8_t s = 0; s + 11 <= size; s += 32) {
+        uint32_t before = 0xffffffff, after = 0xffffffff;
+
+        for (uint8_t k = 0; k < 11; k++) {
+            uint32_t bits = getLineBits(line, words, s + k);
+            before &= (0x05D >> (10 - k)) & 1 ? bits : ~bits;
+            after &= (0x5D0 >> (10 - k)) & 1 ? bits : ~bits;
+        }
+
+        uint8_t starts = size - 10 - s;
+        uint32_t valid = starts >= 32 ? 0xffffffff : ~(0xffffffffu >> starts);
+        result += PENALTY_N3 * (countBits(before & valid) + countBits(after & valid));
+    }
+
+    return result;
+}
+
+// Calculates and returns the penalty score based on state of this QR Code's current modules.
+// This is used by the automatic mask choice algorithm to find the mask pattern that yields the lowest score.
+// Rows are scored a word at a time, and columns are transposed into rows 8 at a time so they
+// are scored the same way.
+static uint32_t getPenaltyScore(BitBucket *modules) {
+    uint32_t result = 0;
+    uint16_t black = 0;
+
+    uint8_t size = modules->bitOffsetOrWidth, words = ROW_WORDS(size);
+
+    QRCode grid;
+    grid.size = size;
+    grid.stride = 0;
+    grid.modules = modules->data;
+
+    uint32_t above[words], line[words];
+    for (uint8_t y = 0; y < size; y++) {
+        getRowWords(&grid, y, line);
+        result += getLinePenalty(line, size);
+
+        for (uint8_t i = 0; i < words; i++) {
+            // 2*2 blocks of modules having same color, ending at column x of this row
+            if (y > 0) {
+                uint32_t left = line[i] >> 1 | (i > 0 ? line[i - 1] << 31 : 0);
+                uint32_t upLeft = above[i] >> 1 | (i > 0 ? above[i - 1] << 31 : 0);
+                uint32_t same = ~(line[i] ^ left) & ~(line[i] ^ above[i]) & ~(line[i] ^ upLeft);
+                result += PENALTY_N2 * countBits(same & rowMask(i, 1, size - 1));
+            }
+
+            // Balance of black and white modules
+            black += countBits(line[i]);
+        }
+
+        memcpy(above, line, sizeof(line));
+    }
+
+    // Adjacent modules and finder-like patterns in columns, a band of 8 at a time
+    for (uint8_t band = 0; band < size; band += 8) {
+        uint32_t columns[8][words];
+        memset(columns, 0, sizeof(columns));
+
+        for (uint8_t y = 0; y < size; y += 8) {
+            uint64_t block = transpose8(getBlock(&grid, band, y));
+            for (uint8_t c = 0; c < 8; c++) {
+                columns[c][y / 32] |= (uint32_t)((block >> (56 - 8 * c)) & 0xff) << (24 - y % 32);
+            }
+        }
+
+        for (uint8_t c = 0; c < 8 && band + c < size; c++) {
+            result += getLinePenalty(columns[c], size);
+        }
+    }
+
+    // Find smallest k such that (45-5k)% <= dark/total <= (55+5k)%
+    uint16_t total = size * size;
+    for (uint16_t k = 0; black * 20 < (9 - k) * total || black * 20 > (11 + k) * total; k++) {
+        result += PENALTY_N4;
+    }
+
+    return result;
+}
+
+
 #pragma mark - Public QRCode functions
 
 uint16_t qrcode_getBufferSize(uint8_t version) {
     return bb_getGridSizeBytes(4 * version + 17);
 }
 
+uint16_t qrcode_getAlignedBufferSize(uint8_t version) {
+    uint8_t size = 4 * version + 17;
+    return size * ((size + 7) / 8);
+}
+
 int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, uint8_t *data, uint16_t length) {
     static uint16_t maxlength[40][4] = {
         // Max bytes for each ECC and VERSION
@@ -821,6 +1062,9 @@ int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8
         { 2953, 2331, 1663, 1273 }
     };
 
+    bool alignRows = (ecc & QRCODE_ALIGN_ROWS) != 0;
+    ecc &= ~QRCODE_ALIGN_ROWS;
+
     if (ecc < ECC_LOW || ecc > ECC_HIGH) { return -1; }
     uint8_t eccFormatBits = (ECC_FORMAT_BITS >> (2 * ecc)) & 0x03;
 
@@ -845,6 +1089,7 @@ int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8
     qrcode->version = version;
     qrcode->size = size;
     qrcode->ecc = ecc;
+    qrcode->stride = 0;
     qrcode->modules = modules;
 
     struct BitBucket codewords;
@@ -902,6 +1147,8 @@ int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8
     // Apply the final choice of mask
     applyMask(&modulesGrid, &isFunctionGrid, mask);
 
+    if (alignRows) { alignModuleRows(qrcode); }
+
     return 0;
 }
 
@@ -911,21 +1158,457 @@ int8_t qrcode_initText(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_
     return qrcode_initBytes(qrcode, modules, version, ecc, (uint8_t*)data, (uint16_t)length);
 }
 
+uint8_t qrcode_getAlignmentPositions(uint8_t version, uint8_t *positions) {
+    return getAlignmentPositions(version, positions);
+}
+
 bool qrcode_getModule(QRCode *qrcode, uint8_t x, uint8_t y) {
     if (x < 0 || x >= qrcode->size || y < 0 || y >= qrcode->size) {
         return false;
     }
 
-    uint32_t offset = y * qrcode->size + x;
+    uint32_t offset = getModuleOffset(qrcode, x, y);
     return (qrcode->modules[offset >> 3] & (128 >> (offset & 0x07))) != 0;
 }
 
-/*
-uint8_t qrcode_getHexLength(QRCode *qrcode) {
-    return ((qrcode->size * qrcode->size) + 7) / 4;
+int8_t qrcode_copyRows(QRCode *qrcode, uint8_t *buffer, uint32_t stride, uint8_t options) {
+    uint8_t size = qrcode->size, words = ROW_WORDS(size);
+    bool wordRows = (options & QRCODE_ROWS_WORDS) != 0, lsbFirst = (options & QRCODE_ROWS_LSB_FIRST) != 0;
+    uint8_t rowBytes = wordRows ? words * 4 : (size + 7) / 8;
+
+    if (!buffer || stride < rowBytes || (wordRows && stride % 4)) { return -1; }
+
+    for (uint8_t y = 0; y < size; y++, buffer += stride) {
+        uint32_t row[words];
+        getRowWords(qrcode, y, row);
+
+        for (uint8_t i = 0; i < words; i++) {
+            uint32_t word = row[i];
+
+            if (wordRows) {
+                if (lsbFirst) { word = reverseBits(word); }
+                memcpy(buffer + 4 * i, &word, 4);
+            } else {
+                if (lsbFirst) { word = reverseByteBits(word); }
+                for (uint8_t j = 0; j < 4 && 4 * i + j < rowBytes; j++) { buffer[4 * i + j] = (uint8_t)(word >> (24 - 8 * j)); }
+            }
+        }
+    }
+
+    return 0;
 }
 
-void qrcode_getHex(QRCode *qrcode, char *result) {
+// Clears columns [x, x + width) in a word that starts at column "origin".
+static uint32_t coverClear(uint32_t word, int16_t origin, int16_t x, uint8_t width) {
+    int16_t start = x - origin, end = start + width;
+    if (start < 0) { start = 0; }
+    if (end > 32) { end = 32; }
+    return start < end ? word & ~rowMask(0, start, end - start) : word;
+}
+
+// Returns the 32 modules of row y that the cover must include, starting at column x (which
+// may be -1).
+static uint32_t getCoverWord(QRCode *qrcode, const QRCodeRectCursor *cursor, uint8_t y, int16_t x) {
+    uint8_t size = qrcode->size;
+    uint32_t word = x < 0 ? getRowWord(qrcode, y, 0) >> -x : getRowWord(qrcode, y, x);
+    if (!(cursor->options & QRCODE_COVER_DATA) || !word) { return word; }
+
+    // The finder and alignment patterns are drawn separately...
+    if (y < 7) {
+        word = coverClear(coverClear(word, x, 0, 7), x, size - 7, 7);
+    } else if (y >= size - 7) {
+        word = coverClear(word, x, 0, 7);
+    }
 
+    const uint8_t *align = cursor->align;
+    uint8_t alignCount = cursor->alignCount;
+    for (uint8_t j = 0; j < alignCount; j++) {
+        if (y + 2 < align[j] || y > align[j] + 2) { continue; }
+        for (uint8_t i = 0; i < alignCount; i++) {
+            if ((i == 0 && j == 0) || (i == 0 && j == alignCount - 1) || (i == alignCount - 1 && j == 0)) {
+                continue;
+            }
+            word = coverClear(word, x, align[i] - 2, 5);
+        }
+    }
+
+    return word;
+}
+
+// Returns the number of consecutive modules of the cover in row y from column x.
+static uint8_t coverRunLength(QRCode *qrcode, const QRCodeRectCursor *cursor, uint8_t y, uint8_t x) {
+    uint8_t length = 0, count;
+    do {
+        length += (count = countLeadingZeros(~getCoverWord(qrcode, cursor, y, x + length)));
+    } while (count == 32);
+    return length;
+}
+
+// Returns true if row y of the cover has a run of exactly [x, x + width).
+static bool coverHasRun(QRCode *qrcode, const QRCodeRectCursor *cursor, uint8_t y, uint8_t x, uint8_t width) {
+    // One word from the column before the run: bit 31 is x - 1 and bit 30 - width is x + width
+    uint32_t word = getCoverWord(qrcode, cursor, y, x - 1);
+    if (width > 30) { return !(word & 0x80000000u) && coverRunLength(qrcode, cursor, y, x) == width; }
+
+    uint32_t run = (0xffffffffu >> (32 - width)) << (31 - width);
+    return (word & (run | 0x80000000u | (1u << (30 - width)))) == run;
+}
+
+// Rows of the finder and alignment patterns, leftmost module in the most significant bit
+static const uint8_t FINDER_ROWS[7] = { 0x7f, 0x41, 0x5d, 0x5d, 0x5d, 0x41, 0x7f };
+static const uint8_t ALIGNMENT_ROWS[5] = { 0x1f, 0x11, 0x15, 0x11, 0x1f };
+
+// Returns true if the width x width modules at (x, y) match the pattern rows.
+static bool coverHasPattern(QRCode *qrcode, uint8_t x, uint8_t y, uint8_t width, const uint8_t *rows) {
+    for (uint8_t i = 0; i < width; i++) {
+        if (getRowWord(qrcode, y + i, x) >> (32 - width) != rows[i]) { return false; }
+    }
+    return true;
+}
+
+// Returns true if every finder and alignment pattern is in its usual place, which is no
+// longer the case after most qrcode_transform() transforms.
+static bool coverHasPatterns(QRCode *qrcode, const QRCodeRectCursor *cursor) {
+    uint8_t size = qrcode->size, alignCount = cursor->alignCount;
+    const uint8_t *align = cursor->align;
+
+    if (!coverHasPattern(qrcode, 0, 0, 7, FINDER_ROWS) || !coverHasPattern(qrcode, size - 7, 0, 7, FINDER_ROWS) ||
+        !coverHasPattern(qrcode, 0, size - 7, 7, FINDER_ROWS)) {
+        return false;
+    }
+
+    for (uint8_t j = 0; j < alignCount; j++) {
+        for (uint8_t i = 0; i < alignCount; i++) {
+            if ((i == 0 && j == 0) || (i == 0 && j == alignCount - 1) || (i == alignCount - 1 && j == 0)) {
+                continue;
+            }
+            if (!coverHasPattern(qrcode, align[i] - 2, align[j] - 2, 5, ALIGNMENT_ROWS)) { return false; }
+        }
+    }
+    return true;
+}
+
+void qrcode_rectsBegin(QRCode *qrcode, QRCodeRectCursor *cursor, uint8_t options) {
+    cursor->options = options;
+    cursor->alignCount = getAlignmentPositions(qrcode->version, cursor->align);
+
+    // Patterns that have been moved or inverted must be covered like any other modules
+    if ((options & QRCODE_COVER_DATA) && !coverHasPatterns(qrcode, cursor)) {
+        cursor->options &= ~QRCODE_COVER_DATA;
+    }
+    cursor->x = 0;
+    cursor->y = 0;
+}
+
+bool qrcode_nextRect(QRCode *qrcode, QRCodeRectCursor *cursor, QRCodeRect *rect) {
+    uint8_t size = qrcode->size;
+
+    // Each run of dark modules starts a rectangle, unless the row above has the same run
+    // (then it is part of that rectangle), and the rectangle takes in the same run in the
+    // rows below.  A lone module instead belongs to a one module wide rectangle down its
+    // column, started by the topmost lone module in it.  Nothing needs to be remembered
+    // between rectangles...
+    for (; cursor->y < size; cursor->y++, cursor->x = 0) {
+        uint8_t y = cursor->y;
+
+        for (uint8_t x = cursor->x; x < size;) {
+            uint32_t word = getCoverWord(qrcode, cursor, y, x);
+            if (!word) {
+                x = size - x > 32 ? x + 32 : size;
+                continue;
+            }
+            x += countLeadingZeros(word);
+
+            uint8_t width = coverRunLength(qrcode, cursor, y, x), top = y, bottom = y + 1;
+
+            if (width > 1) {
+                if (y > 0 && coverHasRun(qrcode, cursor, y - 1, x, width)) {
+                    x += width;
+                    continue;
+                }
+                while (bottom < size && coverHasRun(qrcode, cursor, bottom, x, width)) { bottom++; }
+            } else {
+                // Bits 31, 30 and 29 of each word are columns x - 1, x and x + 1
+                while (top > 0) {
+                    word = getCoverWord(qrcode, cursor, top - 1, x - 1);
+                    if (!(word & 0x40000000u) || (word & 0xe0000000u) == 0x40000000u) { break; }
+                    top--;
+                }
+                if (top > 0 && (word & 0xe0000000u) == 0x40000000u) {
+                    x++;
+                    continue;
+                }
+                while (bottom < size) {
+                    word = getCoverWord(qrcode, cursor, bottom, x - 1);
+                    if (!(word & 0x40000000u)) { break; }
+                    bottom++;
+                }
+            }
+
+            rect->x = x;
+            rect->y = top;
+            rect->width = width;
+            rect->height = bottom - top;
+            cursor->x = x + width;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint16_t qrcode_coverRects(QRCode *qrcode, uint8_t options, QRCodeRect *rects, uint16_t maxRects) {
+    QRCodeRectCursor cursor;
+    QRCodeRect rect;
+    uint16_t count = 0;
+
+    qrcode_rectsBegin(qrcode, &cursor, options);
+    while (qrcode_nextRect(qrcode, &cursor, &rect)) {
+        if (rects && count < maxRects) { rects[count] = rect; }
+        count++;
+    }
+
+    return count;
+}
+
+int8_t qrcode_traceContours(QRCode *qrcode, QRCodeContourCallback cb, void *ctx) {
+    // Directions: 0 = east, 1 = south, 2 = west, 3 = north
+    static const int8_t dx[4] = { 1, 0, -1, 0 }, dy[4] = { 0, 1, 0, -1 };
+
+    uint8_t size = qrcode->size, words = ROW_WORDS(size);
+
+    // Every outline has at least one horizontal edge, so remembering which of those
+    // have been traced is enough to visit each outline once
+    uint32_t above[words], below[words], edges[words], traced[size + 1][words];
+    memset(above, 0, sizeof(above));
+    memset(traced, 0, sizeof(traced));
+
+    for (uint8_t y = 0; y <= size; y++) {
+        if (y < size) {
+            getRowWords(qrcode, y, below);
+        } else {
+            memset(below, 0, sizeof(below));
+        }
+
+        for (uint8_t i = 0; i < words; i++) { edges[i] = (above[i] ^ below[i]) & ~traced[y][i]; }
+
+        for (uint8_t x = rowFindSet(edges, size, 0); x < size; x = rowFindSet(edges, size, x)) {
+            // Walk the outline keeping dark modules on the right, so outer edges run
+            // clockwise and holes counter-clockwise; only the corners are reported
+            uint8_t start = (below[x / 32] & (0x80000000u >> (x % 32))) ? 0 : 2;
+            uint8_t dir = start, startX = start ? x + 1 : x, cx = startX, cy = y, firstX = 0, firstY = 0;
+            bool first = true;
+
+            do {
+                if (dir == 0 || dir == 2) {
+                    uint8_t edge = dir ? cx - 1 : cx;
+                    traced[cy][edge / 32] |= 0x80000000u >> (edge % 32);
+                }
+                cx += dx[dir];
+                cy += dy[dir];
+
+                // Turn right when the module ahead on the right is light, left when the module
+                // ahead on the left is dark (modules touching at a corner are separate)
+                uint8_t next = dir;
+                if (!getCornerModule(qrcode, cx, cy, (dir + 2) & 3)) {
+                    next = (dir + 1) & 3;
+                } else if (getCornerModule(qrcode, cx, cy, (dir + 1) & 3)) {
+                    next = (dir + 3) & 3;
+                }
+
+                if (next != dir) {
+                    if (!(cb)(ctx, first ? QRCODE_CONTOUR_MOVE : QRCODE_CONTOUR_LINE, cx, cy)) { return -1; }
+                    if (first) {
+                        firstX = cx;
+                        firstY = cy;
+                        first = false;
+                    }
+                    dir = next;
+                }
+            } while (cx != startX || cy != y || dir != start);
+
+            if (!(cb)(ctx, QRCODE_CONTOUR_CLOSE, firstX, firstY)) { return -1; }
+
+            for (uint8_t i = 0; i < words; i++) { edges[i] &= ~traced[y][i]; }
+        }
+
+        memcpy(above, below, sizeof(above));
+    }
+
+    return 0;
+}
+
+// Merges "rect" with every rectangle in "list" that it overlaps or touches, removing them from
+// the list, until none are left.
+static void diff_merge(QRCodeRect *rect, QRCodeRect *list, uint16_t *count) {
+    for (uint16_t i = 0; i < *count;) {
+        QRCodeRect *other = list + i;
+
+        if (other->x > rect->x + rect->width || rect->x > other->x + other->width) {
+            i++;
+            continue;
+        }
+
+        uint8_t left = rect->x < other->x ? rect->x : other->x;
+        uint8_t right = max(rect->x + rect->width, other->x + other->width);
+        uint8_t top = rect->y < other->y ? rect->y : other->y;
+        uint8_t bottom = max(rect->y + rect->height, other->y + other->height);
+
+        rect->x = left;
+        rect->y = top;
+        rect->width = right - left;
+        rect->height = bottom - top;
+
+        // The rectangle grew, so check the whole list again...
+        *other = list[--*count];
+        i = 0;
+    }
+}
+
+uint16_t qrcode_diff(QRCode *oldCode, QRCode *newCode, QRCodeRect *rects, uint16_t maxRects) {
+    // A different size changes everything...
+    if (oldCode->size != newCode->size) {
+        uint8_t size = max(oldCode->size, newCode->size);
+        if (rects && maxRects > 0) {
+            rects[0].x = rects[0].y = 0;
+            rects[0].width = rects[0].height = size;
+        }
+        return 1;
+    }
+
+    uint8_t size = newCode->size, words = ROW_WORDS(size);
+
+    // Rectangles reaching the previous row stay open while the changes below touch them; the
+    // spans of a row are separated by clean gaps, so there are at most size / 2 + 1
+    QRCodeRect open[size / 2 + 1], next[size / 2 + 1];
+    uint16_t openCount = 0, count = 0;
+
+    for (uint16_t y = 0; y <= size; y++) {
+        uint32_t dirty[words];
+        uint16_t nextCount = 0;
+
+        for (uint8_t i = 0; i < words; i++) {
+            dirty[i] = y < size ? getRowWord(oldCode, y, i * 32) ^ getRowWord(newCode, y, i * 32) : 0;
+        }
+
+        for (uint8_t x = rowFindSet(dirty, size, 0); x < size; x = rowFindSet(dirty, size, x)) {
+            // Grow the span over narrow clean gaps...
+            uint8_t end = x + rowRunLength(dirty, size, x), following;
+            while ((following = rowFindSet(dirty, size, end)) < size && following - end < QRCODE_DIFF_GAP) {
+                end = following + rowRunLength(dirty, size, following);
+            }
+
+            // ...then join it to the rectangles it touches above and on this row
+            QRCodeRect rect = { x, (uint8_t)y, (uint8_t)(end - x), 1 };
+            uint16_t before;
+            do {
+                before = openCount + nextCount;
+                diff_merge(&rect, open, &openCount);
+                diff_merge(&rect, next, &nextCount);
+            } while (openCount + nextCount != before);
+
+            rect.height = (uint8_t)(y + 1 - rect.y);
+            next[nextCount++] = rect;
+            x = end;
+        }
+
+        // Rectangles not continued by this row are finished...
+        for (uint16_t i = 0; i < openCount; i++) {
+            if (rects && count < maxRects) { rects[count] = open[i]; }
+            count++;
+        }
+
+        memcpy(open, next, nextCount * sizeof(QRCodeRect));
+        openCount = nextCount;
+    }
+
+    return count;
+}
+
+void qrcode_runBegin(QRCodeRunCursor *cursor, uint8_t direction, uint8_t line) {
+    cursor->direction = direction;
+    cursor->line = line;
+    cursor->position = 0;
+    cursor->loaded = false;
+}
+
+bool qrcode_nextRun(QRCode *qrcode, QRCodeRunCursor *cursor, uint8_t *x, uint8_t *length) {
+    uint8_t size = qrcode->size;
+
+    while (cursor->line < size) {
+        if (!cursor->loaded) {
+            if (cursor->direction == QRCODE_RUN_COLUMNS) {
+                getColumnWords(qrcode, cursor->line, cursor->words);
+            } else {
+                getRowWords(qrcode, cursor->line, cursor->words);
+            }
+            cursor->position = 0;
+            cursor->loaded = true;
+        }
+
+        // Both ends of the run are found a word at a time...
+        uint8_t start = rowFindSet(cursor->words, size, cursor->position);
+        if (start < size) {
+            *x = start;
+            *length = rowRunLength(cursor->words, size, start);
+            cursor->position = start + *length;
+            return true;
+        }
+
+        cursor->line++;
+        cursor->loaded = false;
+    }
+
+    return false;
+}
+
+void qrcode_transform(QRCode *qrcode, uint8_t transform) {
+    uint8_t size = qrcode->size, words = ROW_WORDS(size);
+
+    // Swap the 8x8 blocks across the diagonal, transposing each...
+    if (transform & QRCODE_TRANSPOSE) {
+        for (uint8_t by = 0; by < size; by += 8) {
+            for (uint8_t bx = by; bx < size; bx += 8) {
+                uint64_t upper = getBlock(qrcode, bx, by), lower = getBlock(qrcode, by, bx);
+                setBlock(qrcode, bx, by, transpose8(lower));
+                setBlock(qrcode, by, bx, transpose8(upper));
+            }
+        }
+    }
+
+    if (!(transform & (QRCODE_MIRROR | QRCODE_FLIP | QRCODE_INVERT))) { return; }
+
+    // ...then the other transforms work on pairs of rows from the top and bottom
+    for (uint8_t top = 0; top < (size + 1) / 2; top++) {
+        uint8_t bottom = size - 1 - top;
+        uint32_t rows[2][words];
+
+        getRowWords(qrcode, top, rows[0]);
+        getRowWords(qrcode, bottom, rows[1]);
+
+        for (uint8_t r = 0; r < 2; r++) {
+            uint32_t *row = rows[r];
+
+            if (transform & QRCODE_MIRROR) {
+                // Reverse the words and their bits, then shift the row back to column 0
+                uint8_t shift = words * 32 - size;
+                for (uint8_t i = 0; i < (words + 1) / 2; i++) {
+                    uint32_t word = reverseBits(row[i]);
+                    row[i] = reverseBits(row[words - 1 - i]);
+                    row[words - 1 - i] = word;
+                }
+                for (uint8_t i = 0; shift && i < words; i++) {
+                    row[i] = row[i] << shift | (i + 1 < words ? row[i + 1] >> (32 - shift) : 0);
+                }
+            }
+
+            if (transform & QRCODE_INVERT) {
+                for (uint8_t i = 0; i < words; i++) { row[i] = ~row[i]; }
+            }
+        }
+
+        bool flip = (transform & QRCODE_FLIP) != 0;
+        setRowWords(qrcode, top, rows[flip ? 1 : 0]);
+        if (bottom != top) { setRowWords(qrcode, bottom, rows[flip ? 0 : 1]); }
+    }
 }
-*/
@@ -39,6 +39,7 @@
 #define __QRCODE_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -76,10 +77,159 @@ typedef struct QRCode {
     uint8_t ecc;
     uint8_t mode;
     uint8_t mask;
+    uint8_t stride;             // Bytes per row with QRCODE_ALIGN_ROWS, 0 when rows are packed end to end
     uint8_t *modules;
 } QRCode;
 
 
+// Option for qrcode_initText() and qrcode_initBytes(), combined with the ECC level: start each
+// row of modules on a byte boundary (the buffer takes qrcode_getAlignedBufferSize() bytes)
+#define QRCODE_ALIGN_ROWS   0x80
+
+
+// Axis-aligned rectangle of dark modules returned by qrcode_nextRect() and qrcode_coverRects()
+typedef struct QRCodeRect {
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;
+    uint8_t height;
+} QRCodeRect;
+
+// Clean gaps narrower than this many modules are included in qrcode_diff() rectangles, so a
+// row of scattered changes becomes a single window
+#ifndef QRCODE_DIFF_GAP
+#define QRCODE_DIFF_GAP     4
+#endif
+
+// qrcode_rectsBegin() and qrcode_coverRects() options
+#define QRCODE_COVER_ALL    0x00    // Cover every dark module
+#define QRCODE_COVER_DATA   0x01    // Leave the finder and alignment patterns uncovered
+
+// State of qrcode_nextRect(): its position in the symbol and the alignment pattern positions;
+// QRCODE_COVER_DATA is cleared from the options when the patterns are not in their usual
+// places (after qrcode_transform()), so every dark module is covered
+typedef struct QRCodeRectCursor {
+    uint8_t options;
+    uint8_t x;
+    uint8_t y;
+    uint8_t alignCount;
+    uint8_t align[7];
+} QRCodeRectCursor;
+
+
+// qrcode_traceContours() commands; outlines are closed polygons in module corner
+// coordinates (0 to size), clockwise around dark areas and counter-clockwise around holes
+#define QRCODE_CONTOUR_MOVE     0   // Start a new outline at (x, y)
+#define QRCODE_CONTOUR_LINE     1   // Straight edge to (x, y)
+#define QRCODE_CONTOUR_CLOSE    2   // Edge back to the start of the outline at (x, y)
+
+// Contour callback; returns false to stop tracing
+typedef bool (*QRCodeContourCallback)(void *ctx, uint8_t command, uint8_t x, uint8_t y);
+
+
+// qrcode_runBegin() directions
+#define QRCODE_RUN_ROWS     0   // Runs along each row, top to bottom
+#define QRCODE_RUN_COLUMNS  1   // Runs down each column, left to right
+
+// Run cursor for qrcode_nextRun(); "line" is the row (or column) of the last run returned
+// and the other fields are private.
+typedef struct QRCodeRunCursor {
+    uint8_t direction;
+    uint8_t line;
+    uint8_t position;
+    bool loaded;
+    uint32_t words[6];
+} QRCodeRunCursor;
+
+
+// qrcode_copyRows() options
+#define QRCODE_ROWS_MSB_FIRST   0x00    // Leftmost module in the most significant bit
+#define QRCODE_ROWS_LSB_FIRST   0x01    // Leftmost module in the least significant bit
+#define QRCODE_ROWS_WORDS       0x02    // Rows of native 32-bit words; the stride is a multiple of 4
+
+
+// qrcode_transform() transforms, applied in this order; combine them for the rotations
+#define QRCODE_TRANSPOSE    0x01    // Swap rows and columns
+#define QRCODE_MIRROR       0x02    // Reverse each row, left to right
+#define QRCODE_FLIP         0x04    // Reverse the order of the rows, top to bottom
+#define QRCODE_INVERT       0x08    // Swap dark and light modules
+#define QRCODE_ROTATE_90    (QRCODE_TRANSPOSE | QRCODE_MIRROR)  // Clockwise
+#define QRCODE_ROTATE_180   (QRCODE_MIRROR | QRCODE_FLIP)
+#define QRCODE_ROTATE_270   (QRCODE_TRANSPOSE | QRCODE_FLIP)
+
+// qrcode_getImageSize() and qrcode_renderImage() formats
+#define QRCODE_IMAGE_PBM    0   // Binary PBM (P4), 1 bit per pixel
+#define QRCODE_IMAGE_PGM    1   // Binary PGM (P5), 8 bits per pixel
+#define QRCODE_IMAGE_BMP    2   // Windows BMP, 1 bit per pixel
+
+
+// qrcode_blit() pixel formats
+#define QRCODE_PIXEL_RGB565     0   // 16 bits per pixel
+#define QRCODE_PIXEL_ARGB8888   1   // 32 bits per pixel
+
+
+// qrcode_writeESCPOS() modes
+#define QRCODE_ESCPOS_RASTER    0   // "GS v 0" raster bit images
+#define QRCODE_ESCPOS_COLUMN    1   // "ESC *" 24 dot column bit images
+
+
+// qrcode_writeText() options
+#define QRCODE_TEXT_INVERT      0x01    // Draw the light modules, for light text on a dark terminal
+#define QRCODE_TEXT_ANSI        0x02    // Set the colors with ANSI escapes on each line
+
+
+// qrcode_writeDataURI() image formats
+#define QRCODE_URI_PNG          0   // data:image/png;base64,...
+#define QRCODE_URI_SVG          1   // data:image/svg+xml;base64,...
+
+
+// Output callback used by the image writers; returns false on error
+typedef bool (*QRCodeWriteCallback)(void *ctx, const uint8_t *data, size_t length);
+
+
+// Size of the PNG output buffer (and of each IDAT chunk); this bounds memory use for any
+// scale/border
+#ifndef QRCODE_PNG_BUFSIZE
+#define QRCODE_PNG_BUFSIZE  256
+#endif
+
+
+// Deflate alphabet sizes: literal/length codes and distance codes
+#define QRCODE_DEFLATE_LITERALS     286
+#define QRCODE_DEFLATE_DISTANCES    30
+
+
+// Encoder state for the PNG writer (about 1.6k). Callers that write many images can
+// keep one, e.g. in static storage, and reuse it instead of putting a new one on the
+// stack for each image. The fields are private.
+typedef struct QRCodeEncoder {
+    QRCodeWriteCallback cb;
+    void *ctx;
+    bool ok;
+    bool counting;
+    uint32_t bits;
+    uint8_t bitCount;
+    uint8_t runByte;
+    uint32_t runCount;
+    uint32_t adlerA, adlerB;
+    uint32_t lit[QRCODE_DEFLATE_LITERALS];
+    uint32_t dist[QRCODE_DEFLATE_DISTANCES];
+    size_t length;
+    uint8_t buffer[QRCODE_PNG_BUFSIZE];
+    uint8_t line[QRCODE_PNG_BUFSIZE / 4];
+} QRCodeEncoder;
+
+// Raster iterator state for qrcode_rasterBegin() and qrcode_rasterNext(). The fields are
+// private.
+typedef struct QRCodeRaster {
+    QRCode *qrcode;
+    uint8_t scale;
+    uint8_t border;
+    uint32_t width;
+    uint32_t row;
+} QRCodeRaster;
+
+
 #ifdef __cplusplus
 extern "C"{
 #endif  /* __cplusplus */
@@ -87,11 +237,60 @@ extern "C"{
 
 
 uint16_t qrcode_getBufferSize(uint8_t version);
+uint16_t qrcode_getAlignedBufferSize(uint8_t version);
 
 int8_t qrcode_initText(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, const char *data);
 int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, uint8_t *data, uint16_t length);
 
 bool qrcode_getModule(QRCode *qrcode, uint8_t x, uint8_t y);
+int8_t qrcode_copyRows(QRCode *qrcode, uint8_t *buffer, uint32_t stride, uint8_t options);
+void qrcode_transform(QRCode *qrcode, uint8_t transform);
+
+uint8_t qrcode_getAlignmentPositions(uint8_t version, uint8_t *positions);
+
+uint16_t qrcode_coverRects(QRCode *qrcode, uint8_t options, QRCodeRect *rects, uint16_t maxRects);
+void qrcode_rectsBegin(QRCode *qrcode, QRCodeRectCursor *cursor, uint8_t options);
+bool qrcode_nextRect(QRCode *qrcode, QRCodeRectCursor *cursor, QRCodeRect *rect);
+int8_t qrcode_traceContours(QRCode *qrcode, QRCodeContourCallback cb, void *ctx);
+uint16_t qrcode_diff(QRCode *oldCode, QRCode *newCode, QRCodeRect *rects, uint16_t maxRects);
+
+void qrcode_runBegin(QRCodeRunCursor *cursor, uint8_t direction, uint8_t line);
+bool qrcode_nextRun(QRCode *qrcode, QRCodeRunCursor *cursor, uint8_t *x, uint8_t *length);
+
+int8_t qrcode_writePNG(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writePNGWithEncoder(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx, QRCodeEncoder *encoder);
+int8_t qrcode_writeGrayPNG(QRCode *qrcode, uint16_t size, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeGrayPNGWithEncoder(QRCode *qrcode, uint16_t size, uint8_t border, QRCodeWriteCallback cb, void *ctx, QRCodeEncoder *encoder);
+int8_t qrcode_writeSVG(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeSVGSheet(QRCode *qrcodes, uint16_t count, uint16_t columns, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_renderRow(QRCode *qrcode, uint32_t row, uint8_t scale, uint8_t border, uint8_t *buffer);
+int8_t qrcode_renderBitmap(QRCode *qrcode, uint8_t scale, uint8_t border, uint8_t *buffer, uint32_t stride);
+void qrcode_rasterBegin(QRCodeRaster *raster, QRCode *qrcode, uint8_t scale, uint8_t border);
+uint16_t qrcode_rasterNext(QRCodeRaster *raster, uint8_t *buffer, uint32_t stride, uint16_t lines);
+int8_t qrcode_renderGray(QRCode *qrcode, uint16_t size, uint8_t border, uint8_t *buffer, uint32_t stride);
+int8_t qrcode_writePGM(QRCode *qrcode, uint16_t size, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+uint32_t qrcode_getImageSize(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border);
+int8_t qrcode_renderImage(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, uint8_t *buffer, uint32_t size);
+int8_t qrcode_renderPages(QRCode *qrcode, uint8_t scale, uint8_t border, int16_t x, int16_t y, uint8_t *buffer, uint16_t width, uint16_t height);
+int8_t qrcode_blit(QRCode *qrcode, void *buffer, uint32_t stride, uint16_t width, uint16_t height, uint8_t format, int16_t x, int16_t y, uint8_t scale, uint32_t fg, uint32_t bg);
+int8_t qrcode_writeTIFF(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeESCPOS(QRCode *qrcode, uint8_t mode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeZPL(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeText(QRCode *qrcode, uint8_t options, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeEPS(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writeSVGOutline(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writePolylines(QRCode *qrcode, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writePDF(QRCode *qrcodes, uint16_t count, uint16_t columns, uint16_t rows, uint16_t pageWidth, uint16_t pageHeight, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+int8_t qrcode_writePDFWithEncoder(QRCode *qrcodes, uint16_t count, uint16_t columns, uint16_t rows, uint16_t pageWidth, uint16_t pageHeight, uint8_t border, QRCodeWriteCallback cb, void *ctx, QRCodeEncoder *encoder);
+int8_t qrcode_writeGCode(QRCode *qrcode, uint16_t pitch, uint16_t feed, QRCodeWriteCallback cb, void *ctx);
+
+uint16_t qrcode_getHexLength(QRCode *qrcode);
+void qrcode_getHex(QRCode *qrcode, char *result);
+uint16_t qrcode_getBase64Length(QRCode *qrcode);
+void qrcode_getBase64(QRCode *qrcode, char *result);
+int8_t qrcode_writeDataURI(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx);
+uint32_t qrcode_getDataURILength(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border);
+int8_t qrcode_getDataURI(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, char *buffer, uint32_t size);
 
 
 
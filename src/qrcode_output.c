@@ -0,0 +1,2983 @@
+/**
+ * Image output functions for QR codes.
+ *
+ * The MIT License (MIT)
+ *
+ * This library is written and maintained by Richard Moore.
+ * Major parts were derived from Project Nayuki's library.
+ *
+ * Copyright (c) 2025 Michael R Sweet
+ * Copyright (c) 2017 Richard Moore     (https://github.com/ricmoo/QRCode)
+ * Copyright (c) 2017 Project Nayuki    (https://www.nayuki.io/page/qr-code-generator-library)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "qrcode.h"
+
+#include <string.h>
+
+
+#pragma mark - CRC-32 and Adler-32
+
+// CRC-32 table for the PNG/zlib polynomial 0xEDB88320
+static const uint32_t CRC32_TABLE[256] = {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length) {
+    crc = ~crc;
+    while (length-- > 0) {
+        crc = CRC32_TABLE[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#define ADLER32_MOD     65521
+
+// Adds "count" copies of "byte" to the Adler-32 sums in constant time.
+static void adler32_updateRun(uint32_t *a, uint32_t *b, uint8_t byte, uint32_t count) {
+    // b += count * a + byte * count * (count + 1) / 2
+    uint32_t tri;
+    if (count & 1) {
+        tri = (count % ADLER32_MOD) * (((count + 1) / 2) % ADLER32_MOD) % ADLER32_MOD;
+    } else {
+        tri = ((count / 2) % ADLER32_MOD) * ((count + 1) % ADLER32_MOD) % ADLER32_MOD;
+    }
+
+    *b = (*b + (count % ADLER32_MOD) * *a % ADLER32_MOD + tri * byte % ADLER32_MOD) % ADLER32_MOD;
+    *a = (*a + (count % ADLER32_MOD) * byte % ADLER32_MOD) % ADLER32_MOD;
+}
+
+// Appends data of the given length and Adler-32 sums (a2, b2) to the sums (a, b).
+static void adler32_combine(uint32_t *a, uint32_t *b, uint32_t a2, uint32_t b2, uint32_t length) {
+    uint32_t rem = length % ADLER32_MOD;
+
+    // b += b2 + length * (a - 1), a += a2 - 1
+    *b = (*b + b2 + rem * *a % ADLER32_MOD + ADLER32_MOD - rem) % ADLER32_MOD;
+    *a = (*a + a2 + ADLER32_MOD - 1) % ADLER32_MOD;
+}
+
+
+#pragma mark - Deflate
+
+// A minimal zlib/deflate encoder specialized for bilevel scanlines.  Runs of identical bytes
+// are coded as distance 1 back-references and runs of repeated scanlines as one back-reference
+// to the line above; nothing else is matched, so no history window is needed.
+//
+// Since a QR code image is cheap to regenerate, callers make two passes over the same data:
+// the first only counts symbols, which lets the second write a single block with Huffman
+// codes fitted to the image.
+
+#define DEFLATE_MIN_MATCH   3
+#define DEFLATE_MAX_MATCH   258
+#define DEFLATE_MAX_BITS    15
+#define DEFLATE_LITERALS    QRCODE_DEFLATE_LITERALS
+#define DEFLATE_DISTANCES   QRCODE_DEFLATE_DISTANCES
+#define DEFLATE_CODELENS    19
+
+// The encoder state is QRCodeEncoder, which is opaque to callers but declared in qrcode.h so
+// they can own one and reuse it across images.  Its fields:
+//
+//   cb, ctx              Called with each full buffer of compressed data
+//   ok                   false after a write error
+//   counting             true while counting symbols for the Huffman codes
+//   bits, bitCount       Pending output bits, LSB first
+//   runByte, runCount    Pending run of identical input bytes
+//   adlerA, adlerB       Adler-32 of the uncompressed data
+//   lit, dist            Symbol frequencies while counting, then each symbol's
+//                        (length << 16) | code
+//   length, buffer       Compressed output
+//   line                 Scanline buffer for the PNG writer
+typedef QRCodeEncoder DeflateStream;
+
+static const uint16_t DEFLATE_LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t DEFLATE_LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t DEFLATE_DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t DEFLATE_DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Order in which code length code lengths are sent
+static const uint8_t DEFLATE_CODELEN_ORDER[DEFLATE_CODELENS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static void deflate_flush(DeflateStream *stream) {
+    if (stream->length > 0 && stream->ok) {
+        stream->ok = (stream->cb)(stream->ctx, stream->buffer, stream->length);
+    }
+    stream->length = 0;
+}
+
+static void deflate_putByte(DeflateStream *stream, uint8_t byte) {
+    stream->buffer[stream->length++] = byte;
+    if (stream->length == sizeof(stream->buffer)) { deflate_flush(stream); }
+}
+
+// Appends up to 16 bits, least significant bit first.
+static void deflate_putBits(DeflateStream *stream, uint32_t value, uint8_t count) {
+    stream->bits |= value << stream->bitCount;
+    stream->bitCount += count;
+    while (stream->bitCount >= 8) {
+        deflate_putByte(stream, (uint8_t)stream->bits);
+        stream->bits >>= 8;
+        stream->bitCount -= 8;
+    }
+}
+
+// Computes Huffman code lengths no longer than "maxBits" for the given symbol frequencies.
+// At least two symbols must have a non-zero frequency.  The tree is built in place over just
+// the used symbols, sorted by frequency (Moffat and Katajainen), so the weights are scaled to
+// keep every sum within 16 bits.
+static void deflate_buildLengths(const uint32_t *freq, uint16_t count, uint8_t maxBits, uint8_t *lengths) {
+    uint16_t symbols[DEFLATE_LITERALS], weights[DEFLATE_LITERALS], used = 0;
+    uint32_t total = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        lengths[i] = 0;
+        if (freq[i] == 0) { continue; }
+
+        uint16_t j = used++;
+        while (j > 0 && freq[symbols[j - 1]] > freq[i]) {
+            symbols[j] = symbols[j - 1];
+            j--;
+        }
+        symbols[j] = i;
+        total += freq[i];
+    }
+
+    uint8_t shift = 0;
+    while ((total >> shift) + used > 65535) { shift++; }
+
+    for (;;) {
+        for (uint16_t i = 0; i < used; i++) { weights[i] = (uint16_t)((freq[symbols[i]] >> shift) | 1); }
+
+        // Each node joins the two lightest of the remaining leaves and earlier nodes, and
+        // the weight of a joined node is replaced by the index of its parent...
+        weights[0] += weights[1];
+        for (uint16_t next = 1, root = 0, leaf = 2; next < used - 1; next++) {
+            if (leaf >= used || weights[root] < weights[leaf]) {
+                weights[next] = weights[root];
+                weights[root++] = next;
+            } else {
+                weights[next] = weights[leaf++];
+            }
+
+            if (leaf >= used || (root < next && weights[root] < weights[leaf])) {
+                weights[next] += weights[root];
+                weights[root++] = next;
+            } else {
+                weights[next] += weights[leaf++];
+            }
+        }
+
+        // ...then the parents become the depths of the nodes, from the root down...
+        weights[used - 2] = 0;
+        for (int16_t next = (int16_t)used - 3; next >= 0; next--) { weights[next] = weights[weights[next]] + 1; }
+
+        // ...and the leaves take the depths left over at each level, lightest deepest
+        int16_t root = (int16_t)used - 2, next = (int16_t)used - 1;
+        for (uint16_t avail = 1, nodes = 0, depth = 0; avail > 0; avail = 2 * nodes, nodes = 0, depth++) {
+            while (root >= 0 && weights[root] == depth) {
+                nodes++;
+                root--;
+            }
+            while (avail > nodes) {
+                weights[next--] = depth;
+                avail--;
+            }
+        }
+
+        // When the tree is too deep, flatten the frequencies and try again
+        if (weights[0] <= maxBits) { break; }
+        shift++;
+    }
+
+    for (uint16_t i = 0; i < used; i++) { lengths[symbols[i]] = (uint8_t)weights[i]; }
+}
+
+// Assigns canonical Huffman codes for the given lengths, stored bit-reversed for deflate_putBits
+// with the length above them.
+static void deflate_buildCodes(const uint8_t *lengths, uint16_t count, uint32_t *codes) {
+    uint16_t lengthCount[DEFLATE_MAX_BITS + 1], nextCode[DEFLATE_MAX_BITS + 1];
+
+    memset(lengthCount, 0, sizeof(lengthCount));
+    for (uint16_t i = 0; i < count; i++) { lengthCount[lengths[i]]++; }
+    lengthCount[0] = 0;
+
+    uint16_t code = 0;
+    for (uint8_t bits = 1; bits <= DEFLATE_MAX_BITS; bits++) {
+        code = (code + lengthCount[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t length = lengths[i];
+        codes[i] = 0;
+        if (length == 0) { continue; }
+
+        uint16_t value = nextCode[length]++, reversed = 0;
+        for (uint8_t bit = 0; bit < length; bit++, value >>= 1) {
+            reversed = (reversed << 1) | (value & 1);
+        }
+        codes[i] = ((uint32_t)length << 16) | reversed;
+    }
+}
+
+// Appends a code from deflate_buildCodes.
+static void deflate_putCode(DeflateStream *stream, uint32_t code) {
+    deflate_putBits(stream, code & 0xffff, (uint8_t)(code >> 16));
+}
+
+// Appends a literal/length symbol, or just counts it during the first pass.
+static void deflate_putSymbol(DeflateStream *stream, uint16_t symbol) {
+    if (stream->counting) {
+        stream->lit[symbol]++;
+    } else {
+        deflate_putCode(stream, stream->lit[symbol]);
+    }
+}
+
+// Appends a back-reference of any length >= 3, split into codes of at most 258 bytes.
+static void deflate_putMatch(DeflateStream *stream, uint32_t length, uint16_t distance) {
+    uint8_t dcode = 29;
+    while (DEFLATE_DIST_BASE[dcode] > distance) { dcode--; }
+
+    while (length >= DEFLATE_MIN_MATCH) {
+        uint16_t count = length > DEFLATE_MAX_MATCH ? DEFLATE_MAX_MATCH : (uint16_t)length;
+        if (length - count > 0 && length - count < DEFLATE_MIN_MATCH) {
+            count = (uint16_t)(length - DEFLATE_MIN_MATCH);
+        }
+
+        uint8_t lcode = 28;
+        while (DEFLATE_LENGTH_BASE[lcode] > count) { lcode--; }
+
+        deflate_putSymbol(stream, 257 + lcode);
+        if (stream->counting) {
+            stream->dist[dcode]++;
+        } else {
+            deflate_putBits(stream, count - DEFLATE_LENGTH_BASE[lcode], DEFLATE_LENGTH_EXTRA[lcode]);
+            deflate_putCode(stream, stream->dist[dcode]);
+            deflate_putBits(stream, distance - DEFLATE_DIST_BASE[dcode], DEFLATE_DIST_EXTRA[dcode]);
+        }
+
+        length -= count;
+    }
+}
+
+// Codes the pending run as one literal followed by a distance 1 back-reference.
+static void deflate_endRun(DeflateStream *stream) {
+    uint32_t count = stream->runCount;
+    if (count == 0) { return; }
+
+    if (!stream->counting) {
+        adler32_updateRun(&stream->adlerA, &stream->adlerB, stream->runByte, count);
+    }
+
+    deflate_putSymbol(stream, stream->runByte);
+    count--;
+    if (count >= DEFLATE_MIN_MATCH) {
+        deflate_putMatch(stream, count, 1);
+    } else {
+        while (count-- > 0) { deflate_putSymbol(stream, stream->runByte); }
+    }
+
+    stream->runCount = 0;
+}
+
+// Walks the run-length coded code lengths, counting (codes == NULL) or writing them.
+static void deflate_putCodeLengths(DeflateStream *stream, const uint8_t *lengths, uint16_t count, uint32_t *freq, const uint32_t *codes) {
+    for (uint16_t i = 0; i < count;) {
+        uint8_t length = lengths[i];
+        uint16_t run = 1;
+        while (i + run < count && lengths[i + run] == length) { run++; }
+        i += run;
+
+        while (run > 0) {
+            uint8_t symbol;
+            uint16_t repeat = 1;
+
+            if (length == 0 && run >= 11) {
+                symbol = 18;
+                repeat = run > 138 ? 138 : run;
+            } else if (length == 0 && run >= 3) {
+                symbol = 17;
+                repeat = run;
+            } else {
+                symbol = length;
+            }
+
+            if (codes) {
+                deflate_putCode(stream, codes[symbol]);
+                if (symbol == 18) {
+                    deflate_putBits(stream, repeat - 11, 7);
+                } else if (symbol == 17) {
+                    deflate_putBits(stream, repeat - 3, 3);
+                }
+            } else {
+                freq[symbol]++;
+            }
+            run -= repeat;
+
+            // Repeat a non-zero length with code 16 (3 to 6 times)...
+            while (symbol == length && length != 0 && run >= 3) {
+                repeat = run > 6 ? 6 : run;
+                if (codes) {
+                    deflate_putCode(stream, codes[16]);
+                    deflate_putBits(stream, repeat - 3, 2);
+                } else {
+                    freq[16]++;
+                }
+                run -= repeat;
+            }
+        }
+    }
+}
+
+// Starts counting symbols for the first pass.
+static void deflate_begin(DeflateStream *stream, QRCodeWriteCallback cb, void *ctx) {
+    stream->cb = cb;
+    stream->ctx = ctx;
+    stream->ok = true;
+    stream->counting = true;
+    stream->bits = 0;
+    stream->bitCount = 0;
+    stream->runCount = 0;
+    stream->adlerA = 1;
+    stream->adlerB = 0;
+    stream->length = 0;
+
+    memset(stream->lit, 0, sizeof(stream->lit));
+    memset(stream->dist, 0, sizeof(stream->dist));
+}
+
+// The code lengths of the literal/length and distance codes, and the Huffman code used to
+// write them in the block header.
+typedef struct DeflateHeader {
+    uint16_t numLit, numDist;
+    uint8_t numCL;
+    uint8_t lengths[DEFLATE_LITERALS + DEFLATE_DISTANCES];
+    uint32_t clCode[DEFLATE_CODELENS];
+    uint8_t clLen[DEFLATE_CODELENS];
+} DeflateHeader;
+
+// Builds the block header for the current codes and returns its size in bits.
+static uint32_t deflate_buildHeader(DeflateStream *stream, DeflateHeader *header) {
+    uint16_t numLit = DEFLATE_LITERALS, numDist = DEFLATE_DISTANCES;
+    while ((stream->lit[numLit - 1] >> 16) == 0) { numLit--; }
+    while ((stream->dist[numDist - 1] >> 16) == 0) { numDist--; }
+
+    // The code lengths are themselves Huffman coded...
+    for (uint16_t i = 0; i < numLit; i++) { header->lengths[i] = (uint8_t)(stream->lit[i] >> 16); }
+    for (uint8_t i = 0; i < numDist; i++) { header->lengths[numLit + i] = (uint8_t)(stream->dist[i] >> 16); }
+
+    uint32_t clFreq[DEFLATE_CODELENS];
+    memset(clFreq, 0, sizeof(clFreq));
+    deflate_putCodeLengths(stream, header->lengths, numLit + numDist, clFreq, NULL);
+
+    uint32_t bits = 3 + 5 + 5 + 4 + 2 * clFreq[16] + 3 * clFreq[17] + 7 * clFreq[18];
+
+    clFreq[0]++;
+    clFreq[1]++;
+    deflate_buildLengths(clFreq, DEFLATE_CODELENS, 7, header->clLen);
+    deflate_buildCodes(header->clLen, DEFLATE_CODELENS, header->clCode);
+    clFreq[0]--;
+    clFreq[1]--;
+
+    uint8_t numCL = DEFLATE_CODELENS;
+    while (numCL > 4 && header->clLen[DEFLATE_CODELEN_ORDER[numCL - 1]] == 0) { numCL--; }
+
+    for (uint8_t i = 0; i < DEFLATE_CODELENS; i++) { bits += clFreq[i] * header->clLen[i]; }
+
+    header->numLit = numLit;
+    header->numDist = numDist;
+    header->numCL = numCL;
+
+    return bits + 3 * numCL;
+}
+
+// Ends the counting pass and builds the Huffman codes; returns the size of the zlib stream
+// in bytes, so that formats which need it up front can write it before the data.
+static uint32_t deflate_buildTrees(DeflateStream *stream) {
+    DeflateHeader header;
+    uint8_t *litLengths = header.lengths, *distLengths = header.lengths + DEFLATE_LITERALS;
+
+    deflate_endRun(stream);
+
+    // Every tree needs two codes; the unused distance codes cost nothing
+    stream->lit[256] = 1;
+    stream->dist[0]++;
+    stream->dist[1]++;
+
+    deflate_buildLengths(stream->lit, DEFLATE_LITERALS, DEFLATE_MAX_BITS, litLengths);
+    deflate_buildLengths(stream->dist, DEFLATE_DISTANCES, DEFLATE_MAX_BITS, distLengths);
+
+    stream->dist[0]--;
+    stream->dist[1]--;
+
+    // The data size needs the frequencies, so count it before the codes replace them...
+    uint32_t bits = 0;
+    for (uint16_t i = 0; i < DEFLATE_LITERALS; i++) {
+        bits += stream->lit[i] * (litLengths[i] + (i > 256 ? DEFLATE_LENGTH_EXTRA[i - 257] : 0));
+    }
+    for (uint8_t i = 0; i < DEFLATE_DISTANCES; i++) {
+        bits += stream->dist[i] * (distLengths[i] + DEFLATE_DIST_EXTRA[i]);
+    }
+
+    deflate_buildCodes(litLengths, DEFLATE_LITERALS, stream->lit);
+    deflate_buildCodes(distLengths, DEFLATE_DISTANCES, stream->dist);
+
+    bits += deflate_buildHeader(stream, &header);
+
+    return 2 + (bits + 7) / 8 + 4;
+}
+
+// Writes the zlib header, then BFINAL=1, BTYPE=10 (dynamic Huffman) and the codes.
+static void deflate_putHeader(DeflateStream *stream) {
+    DeflateHeader header;
+    deflate_buildHeader(stream, &header);
+
+    stream->counting = false;
+    deflate_putByte(stream, 0x78);  // 32k window, fastest
+    deflate_putByte(stream, 0x01);
+    deflate_putBits(stream, 1 | (2 << 1), 3);
+    deflate_putBits(stream, header.numLit - 257, 5);
+    deflate_putBits(stream, header.numDist - 1, 5);
+    deflate_putBits(stream, header.numCL - 4, 4);
+    for (uint8_t i = 0; i < header.numCL; i++) {
+        deflate_putBits(stream, header.clLen[DEFLATE_CODELEN_ORDER[i]], 3);
+    }
+    deflate_putCodeLengths(stream, header.lengths, header.numLit + header.numDist, NULL, header.clCode);
+}
+
+// Ends the counting pass, builds the Huffman codes and writes the stream and block headers.
+static void deflate_start(DeflateStream *stream) {
+    deflate_buildTrees(stream);
+    deflate_putHeader(stream);
+}
+
+// Adds "count" copies of "byte" to the uncompressed data.
+static void deflate_writeRun(DeflateStream *stream, uint8_t byte, uint32_t count) {
+    if (count == 0) { return; }
+    if (stream->runCount > 0 && stream->runByte != byte) { deflate_endRun(stream); }
+    stream->runByte = byte;
+    stream->runCount += count;
+}
+
+// Repeats the previous "distance" bytes, whose Adler-32 sums are (a, b), "copies" times
+// using a single back-reference.
+static void deflate_writeRepeat(DeflateStream *stream, uint16_t distance, uint32_t copies, uint32_t a, uint32_t b) {
+    deflate_endRun(stream);
+    deflate_putMatch(stream, distance * copies, distance);
+    if (!stream->counting) {
+        while (copies-- > 0) {
+            adler32_combine(&stream->adlerA, &stream->adlerB, a, b, distance);
+        }
+    }
+}
+
+static void deflate_write(DeflateStream *stream, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        const uint8_t *start = data;
+        uint8_t byte = *data;
+        while (length > 0 && *data == byte) {
+            data++;
+            length--;
+        }
+        deflate_writeRun(stream, byte, (uint32_t)(data - start));
+    }
+}
+
+static bool deflate_finish(DeflateStream *stream) {
+    deflate_endRun(stream);
+    deflate_putSymbol(stream, 256);  // End of block
+    if (stream->bitCount > 0) { deflate_putBits(stream, 0, 8 - stream->bitCount); }
+
+    uint32_t adler = (stream->adlerB << 16) | stream->adlerA;
+    deflate_putByte(stream, (uint8_t)(adler >> 24));
+    deflate_putByte(stream, (uint8_t)(adler >> 16));
+    deflate_putByte(stream, (uint8_t)(adler >> 8));
+    deflate_putByte(stream, (uint8_t)adler);
+    deflate_flush(stream);
+
+    return stream->ok;
+}
+
+
+#pragma mark - Bitmap Rows
+
+// Scaled 1-bit rows (most significant bit first, 1 for dark) are the common source for the
+// raster writers.  The module row is first copied into a byte-aligned buffer with the quiet
+// zone on both sides; for scales up to 8 each group of 4 modules then becomes 4 * scale bits
+// from a table, and larger scales are filled a byte at a time.
+
+typedef struct BitmapRenderer {
+    QRCode *qrcode;
+    uint8_t scale;
+    uint8_t border;
+    uint16_t modules;           // Modules across, including the quiet zone
+    uint32_t table[16];         // Pixels for each pattern of 4 modules, right aligned
+} BitmapRenderer;
+
+// Copies module row y into "bits", most significant bit first and starting on a byte
+// boundary, so groups of 4 modules can be read with a shift.
+static void bitmap_getRowBits(QRCode *qrcode, uint8_t y, uint8_t *bits) {
+    if (qrcode->stride) {
+        memcpy(bits, qrcode->modules + y * qrcode->stride, qrcode->stride);
+        return;
+    }
+
+    uint32_t offset = (uint32_t)y * qrcode->size, last = ((uint32_t)qrcode->size * qrcode->size - 1) >> 3;
+    const uint8_t *modules = qrcode->modules + (offset >> 3);
+    uint8_t shift = offset & 7, bytes = (uint8_t)((qrcode->size + 7) / 8);
+
+    for (uint8_t i = 0; i < bytes; i++) {
+        uint8_t next = (offset >> 3) + i + 1 <= last ? modules[i + 1] : 0;
+        bits[i] = shift ? (uint8_t)(modules[i] << shift | next >> (8 - shift)) : modules[i];
+    }
+}
+
+static void bitmap_begin(BitmapRenderer *bitmap, QRCode *qrcode, uint8_t scale, uint8_t border) {
+    bitmap->qrcode = qrcode;
+    bitmap->scale = scale;
+    bitmap->border = border;
+    bitmap->modules = (uint16_t)(qrcode->size + 2 * border);
+
+    if (scale > 8) { return; }
+
+    for (uint8_t n = 0; n < 16; n++) {
+        uint32_t bits = 0;
+
+        for (uint8_t i = 0; i < 4; i++) {
+            bits = (bits << scale) | ((n & (8 >> i)) ? (1u << scale) - 1 : 0);
+        }
+        bitmap->table[n] = bits;
+    }
+}
+
+// Returns the number of bytes in a row.
+static uint32_t bitmap_getRowBytes(BitmapRenderer *bitmap) {
+    return ((uint32_t)bitmap->modules * bitmap->scale + 7) / 8;
+}
+
+// Renders "count" bytes of the row for module row y (outside the symbol for the quiet zone)
+// starting at byte "first".
+static void bitmap_renderBytes(BitmapRenderer *bitmap, int16_t y, uint32_t first, uint32_t count, uint8_t *out) {
+    QRCode *qrcode = bitmap->qrcode;
+    uint8_t scale = bitmap->scale, border = bitmap->border;
+    uint8_t row[(qrcode->size + 7) / 8], modules[(bitmap->modules + 7) / 8 + 3];
+
+    // Place the module row after the left quiet zone...
+    memset(modules, 0, sizeof(modules));
+    if (y >= 0 && y < qrcode->size) {
+        uint8_t shift = border & 7, *dest = modules + border / 8;
+
+        bitmap_getRowBits(qrcode, (uint8_t)y, row);
+        if (qrcode->size & 7) { row[sizeof(row) - 1] &= (uint8_t)(0xff00 >> (qrcode->size & 7)); }
+
+        for (uint8_t i = 0; i < sizeof(row); i++) {
+            dest[i] |= row[i] >> shift;
+            if (shift) { dest[i + 1] = (uint8_t)(row[i] << (8 - shift)); }
+        }
+    }
+
+    uint32_t pixel = first * 8;
+    uint16_t mx = (uint16_t)(pixel / scale);
+    uint8_t used = (uint8_t)(pixel % scale);         // Pixels of module mx already rendered
+    uint64_t bits = 0;                              // Pending pixels, most significant first
+    uint8_t pending = 0;
+
+    while (count > 0) {
+        while (pending < 8) {
+            bool dark = (modules[mx >> 3] & (0x80 >> (mx & 7))) != 0;
+
+            if (used == 0 && scale <= 8) {
+                // 4 modules from the table...
+                uint8_t n = (uint8_t)(((modules[mx >> 3] << 8 | modules[(mx >> 3) + 1]) >> (12 - (mx & 7))) & 15);
+
+                bits |= (uint64_t)bitmap->table[n] << (64 - pending - 4 * scale);
+                pending += 4 * scale;
+                mx += 4;
+            } else if (pending == 0 && scale - used >= 8) {
+                // Whole bytes of a large module...
+                uint32_t bytes = (uint32_t)(scale - used) / 8;
+                if (bytes > count) { bytes = count; }
+
+                memset(out, dark ? 0xff : 0x00, bytes);
+                out += bytes;
+                count -= bytes;
+                if (count == 0) { return; }
+
+                used += (uint8_t)(bytes * 8);
+                if (used == scale) {
+                    mx++;
+                    used = 0;
+                }
+            } else {
+                // The rest of a module, up to the next byte boundary...
+                uint8_t take = (uint8_t)(scale - used);
+                if (take > 56 - pending) { take = (uint8_t)(56 - pending); }
+
+                if (dark) { bits |= (((uint64_t)1 << take) - 1) << (64 - pending - take); }
+                pending += take;
+                used += take;
+                if (used == scale) {
+                    mx++;
+                    used = 0;
+                }
+            }
+        }
+
+        *out++ = (uint8_t)(bits >> 56);
+        bits <<= 8;
+        pending -= 8;
+        count--;
+    }
+}
+
+
+#pragma mark - Grayscale Rows
+
+// Anti-aliased rows for an image of any size: each pixel is shaded by the exact fraction of
+// its area covered by dark modules.  With the symbol and quiet zone being N modules across and
+// the image P pixels, positions are kept in units of 1/P module, so pixel p spans [p * N,
+// (p + 1) * N) and module m spans [m * P, (m + 1) * P), and the overlaps are integers.  The
+// box filter is separable: the module rows overlapping a pixel row are first summed into a
+// coverage value per module column (weighted by their vertical overlap), which is then
+// integrated across each pixel.
+
+#define GRAY_MAX_SIZE       32767   // PNG lines must be within deflate's 32k window
+
+typedef struct GrayRenderer {
+    QRCode *qrcode;
+    uint8_t border;
+    uint16_t modules;           // Modules across, including the quiet zone (N)
+    uint16_t size;              // Pixels across (P)
+} GrayRenderer;
+
+static void gray_begin(GrayRenderer *gray, QRCode *qrcode, uint16_t size, uint8_t border) {
+    gray->qrcode = qrcode;
+    gray->border = border;
+    gray->modules = (uint16_t)(qrcode->size + 2 * border);
+    gray->size = size;
+}
+
+// Returns the module row that contains all of pixel row "row", or -1 if it straddles module
+// rows; rows with the same module row are identical.
+static int32_t gray_getRowKey(GrayRenderer *gray, uint16_t row) {
+    uint32_t top = (uint32_t)row * gray->modules, bottom = top + gray->modules - 1;
+
+    return top / gray->size == bottom / gray->size ? (int32_t)(top / gray->size) : -1;
+}
+
+// Sums the module rows overlapping pixel row "row" into "coverage", one value per module
+// column, weighted by the overlap.
+static void gray_prepareRow(GrayRenderer *gray, uint16_t row, uint16_t *coverage) {
+    QRCode *qrcode = gray->qrcode;
+    uint32_t top = (uint32_t)row * gray->modules, bottom = top + gray->modules, size = gray->size;
+    uint8_t bits[(qrcode->size + 7) / 8];
+
+    memset(coverage, 0, gray->modules * sizeof(uint16_t));
+
+    for (uint32_t my = top / size; my * size < bottom; my++) {
+        int32_t y = (int32_t)my - gray->border;
+        if (y < 0 || y >= qrcode->size) { continue; }
+
+        uint32_t start = my * size > top ? my * size : top, end = (my + 1) * size < bottom ? (my + 1) * size : bottom;
+        uint16_t weight = (uint16_t)(end - start), *dest = coverage + gray->border;
+
+        bitmap_getRowBits(qrcode, (uint8_t)y, bits);
+        for (uint8_t x = 0; x < qrcode->size; x++) {
+            dest[x] += (uint16_t)(weight & (0u - ((bits[x >> 3] >> (7 - (x & 7))) & 1u)));
+        }
+    }
+}
+
+// Renders "count" pixels of the prepared row starting at pixel "first", 0 for black to 255
+// for white.
+static void gray_renderPixels(GrayRenderer *gray, const uint16_t *coverage, uint32_t first, uint32_t count, uint8_t *out) {
+    uint32_t modules = gray->modules, size = gray->size, area = modules * modules;
+    uint32_t pos = first * modules, mx = pos / size;
+
+    while (count-- > 0) {
+        uint32_t right = pos + modules, dark = 0;
+
+        while (pos < right) {
+            uint32_t edge = (mx + 1) * size, end = edge < right ? edge : right;
+
+            dark += (end - pos) * coverage[mx];
+            pos = end;
+            if (pos == edge) { mx++; }
+        }
+
+        *out++ = (uint8_t)(255 - (255 * dark + area / 2) / area);
+    }
+}
+
+
+#pragma mark - PNG Output
+
+typedef struct PNGOutput {
+    QRCodeWriteCallback cb;
+    void *ctx;
+} PNGOutput;
+
+// Stores a 32-bit big-endian value.
+static void png_putUInt32(uint8_t *buffer, uint32_t value) {
+    buffer[0] = (uint8_t)(value >> 24);
+    buffer[1] = (uint8_t)(value >> 16);
+    buffer[2] = (uint8_t)(value >> 8);
+    buffer[3] = (uint8_t)value;
+}
+
+// Writes a complete chunk (length, type, data, and CRC) to the callback.
+static bool png_writeChunk(QRCodeWriteCallback cb, void *ctx, const char *type, const uint8_t *data, uint32_t length) {
+    uint8_t header[8], trailer[4];
+
+    png_putUInt32(header, length);
+    memcpy(header + 4, type, 4);
+    png_putUInt32(trailer, crc32_update(crc32_update(0, header + 4, 4), data, length));
+
+    if (!(cb)(ctx, header, sizeof(header))) { return false; }
+    if (length > 0 && !(cb)(ctx, data, length)) { return false; }
+    return (cb)(ctx, trailer, sizeof(trailer));
+}
+
+// Deflate output callback that wraps each buffer of compressed data in an IDAT chunk.
+static bool png_writeIDAT(void *ctx, const uint8_t *data, size_t length) {
+    PNGOutput *output = (PNGOutput *)ctx;
+    return png_writeChunk(output->cb, output->ctx, "IDAT", data, (uint32_t)length);
+}
+
+// Sends "lines" rows of the quiet zone to the compressor.  The first is coded as a run of
+// white and the rest as a single repeat of it, without generating any pixels.
+static void png_writeQuietZone(DeflateStream *stream, uint16_t linelen, uint32_t lines) {
+    if (lines == 0) { return; }
+
+    deflate_writeRun(stream, 0, 1);  // "None" filter
+    deflate_writeRun(stream, 0xff, linelen - 1u);
+
+    if (lines > 1) {
+        uint32_t a = 1, b = 0;
+        adler32_updateRun(&a, &b, 0, 1);
+        adler32_updateRun(&a, &b, 0xff, linelen - 1u);
+        deflate_writeRepeat(stream, linelen, lines - 1, a, b);
+    }
+}
+
+// Sends all of the scanlines of the image to the compressor.  The first line of each module
+// row uses the "None" filter; its scaled copies use the "Up" filter, which makes them all
+// zeros, and are coded as one zero line plus a single repeat of it.
+static void png_writeLines(QRCode *qrcode, uint8_t scale, uint8_t border, DeflateStream *stream) {
+    BitmapRenderer bitmap;
+    bitmap_begin(&bitmap, qrcode, scale, border);
+
+    uint32_t rowBytes = bitmap_getRowBytes(&bitmap);
+    uint16_t linelen = (uint16_t)(1 + rowBytes);
+    uint8_t *line = stream->line;
+    uint32_t upA = 1, upB = 0;
+
+    adler32_updateRun(&upA, &upB, 2, 1);
+    adler32_updateRun(&upA, &upB, 0, linelen - 1u);
+
+    png_writeQuietZone(stream, linelen, (uint32_t)scale * border);
+
+    for (uint8_t y = 0; stream->ok && y < qrcode->size; y ++) {
+        // PNG uses 0 for black, so each piece of the row is inverted...
+        line[0] = 0;  // "None" filter
+        for (uint32_t x = 0, offset = 1; x < rowBytes; offset = 0) {
+            uint32_t count = rowBytes - x < sizeof(stream->line) - offset ? rowBytes - x : (uint32_t)(sizeof(stream->line) - offset);
+
+            bitmap_renderBytes(&bitmap, y, x, count, line + offset);
+            for (uint32_t i = offset; i < offset + count; i++) { line[i] ^= 0xff; }
+
+            deflate_write(stream, line, offset + count);
+            x += count;
+        }
+
+        if (scale > 1) {
+            deflate_writeRun(stream, 2, 1);  // "Up" filter
+            deflate_writeRun(stream, 0, linelen - 1u);
+        }
+        if (scale > 2) {
+            deflate_writeRepeat(stream, linelen, scale - 2u, upA, upB);
+        }
+    }
+
+    png_writeQuietZone(stream, linelen, (uint32_t)scale * border);
+}
+
+
+// Sends the scanlines of an anti-aliased 8-bit image.  A line identical to the one above
+// is an all zero "Up" line, and a series of them is one zero line plus a repeat of it.
+static void png_writeGrayLines(GrayRenderer *gray, uint16_t *coverage, DeflateStream *stream) {
+    uint16_t size = gray->size, linelen = (uint16_t)(1 + size);
+    uint8_t *line = stream->line;
+    uint32_t upA = 1, upB = 0, ups = 0;
+    int32_t previous = -1;
+
+    adler32_updateRun(&upA, &upB, 2, 1);
+    adler32_updateRun(&upA, &upB, 0, linelen - 1u);
+
+    for (uint16_t row = 0; stream->ok && row <= size; row++) {
+        int32_t key = row < size ? gray_getRowKey(gray, row) : -1;
+
+        if (key >= 0 && key == previous) {
+            ups++;
+            continue;
+        }
+
+        if (ups > 0) {
+            deflate_writeRun(stream, 2, 1);  // "Up" filter
+            deflate_writeRun(stream, 0, linelen - 1u);
+            if (ups > 1) { deflate_writeRepeat(stream, linelen, ups - 1, upA, upB); }
+            ups = 0;
+        }
+        if (row == size) { break; }
+
+        gray_prepareRow(gray, row, coverage);
+
+        line[0] = 0;  // "None" filter
+        for (uint32_t x = 0, offset = 1; x < size; offset = 0) {
+            uint32_t count = size - x < sizeof(stream->line) - offset ? size - x : (uint32_t)(sizeof(stream->line) - offset);
+
+            gray_renderPixels(gray, coverage, x, count, line + offset);
+            deflate_write(stream, line, offset + count);
+            x += count;
+        }
+        previous = key;
+    }
+}
+
+
+#pragma mark - Raw Image Output
+
+// Uncompressed images are rendered straight into a caller-supplied buffer, such as a memory
+// mapped file of qrcode_getImageSize() bytes.  Each module row is rendered once and copied
+// for the remaining rows of its scale.  PBM and BMP use 1 for dark pixels (the BMP palette
+// is white, black) and PGM uses 0.
+
+#define BMP_HEADER_SIZE     62      // File header, BITMAPINFOHEADER and a 2 color palette
+#define BMP_PELS_PER_METER  11811   // 300 dpi
+
+static uint32_t raw_getRowBytes(uint8_t format, uint32_t width) {
+    switch (format) {
+        case QRCODE_IMAGE_PBM:  return (width + 7) / 8;
+        case QRCODE_IMAGE_PGM:  return width;
+        default:                return (width + 31) / 32 * 4;
+    }
+}
+
+static uint8_t raw_putDecimal(uint8_t *buffer, uint32_t value) {
+    char temp[10];
+    uint8_t count = 0, length = 0;
+
+    do {
+        temp[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0) { buffer[length++] = (uint8_t)temp[--count]; }
+    return length;
+}
+
+static void raw_putLE(uint8_t *buffer, uint32_t value, uint8_t bytes) {
+    while (bytes-- > 0) {
+        *buffer++ = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+// Writes the header into "buffer" and returns its length; with a NULL buffer only the
+// length is computed.
+static uint32_t raw_putHeader(uint8_t format, uint32_t width, uint32_t imageSize, uint8_t *buffer) {
+    uint8_t temp[BMP_HEADER_SIZE];
+    uint8_t *ptr = buffer ? buffer : temp;
+
+    if (format == QRCODE_IMAGE_BMP) {
+        if (buffer) {
+            memset(buffer, 0, BMP_HEADER_SIZE);
+            buffer[0] = 'B';
+            buffer[1] = 'M';
+            raw_putLE(buffer + 2, BMP_HEADER_SIZE + imageSize, 4);
+            raw_putLE(buffer + 10, BMP_HEADER_SIZE, 4);
+            raw_putLE(buffer + 14, 40, 4);                  // BITMAPINFOHEADER
+            raw_putLE(buffer + 18, width, 4);
+            raw_putLE(buffer + 22, width, 4);               // Positive height: bottom-up rows
+            raw_putLE(buffer + 26, 1, 2);                   // Planes
+            raw_putLE(buffer + 28, 1, 2);                   // Bits per pixel
+            raw_putLE(buffer + 34, imageSize, 4);
+            raw_putLE(buffer + 38, BMP_PELS_PER_METER, 4);
+            raw_putLE(buffer + 42, BMP_PELS_PER_METER, 4);
+            raw_putLE(buffer + 46, 2, 4);                   // Colors used
+            raw_putLE(buffer + 50, 2, 4);                   // Important colors
+            memset(buffer + 54, 0xff, 3);                   // Index 0 is white, 1 is black
+        }
+        return BMP_HEADER_SIZE;
+    }
+
+    // "P4 width height" or "P5 width height 255"...
+    *ptr++ = 'P';
+    *ptr++ = format == QRCODE_IMAGE_PBM ? '4' : '5';
+    *ptr++ = '\n';
+    ptr += raw_putDecimal(ptr, width);
+    *ptr++ = ' ';
+    ptr += raw_putDecimal(ptr, width);
+    *ptr++ = '\n';
+    if (format == QRCODE_IMAGE_PGM) {
+        memcpy(ptr, "255\n", 4);
+        ptr += 4;
+    }
+
+    return (uint32_t)(ptr - (buffer ? buffer : temp));
+}
+
+// Sets bits [start, end) of a 1 bit row, most significant bit first.
+static void raw_setBits(uint8_t *row, uint32_t start, uint32_t end) {
+    uint32_t first = start >> 3, last = (end - 1) >> 3;
+    uint8_t head = (uint8_t)(0xff >> (start & 7)), tail = (uint8_t)(0xff00 >> (((end - 1) & 7) + 1));
+
+    if (first == last) {
+        row[first] |= head & tail;
+    } else {
+        row[first] |= head;
+        memset(row + first + 1, 0xff, last - first - 1);
+        row[last] |= tail;
+    }
+}
+
+// Renders module row y (or a quiet zone row for y < 0) into "row".  PGM rows are rendered
+// as bits and then expanded in place from the end, so no byte is overwritten before it has
+// been read.
+static void raw_renderRow(BitmapRenderer *bitmap, uint8_t format, int16_t y, uint32_t width, uint32_t rowBytes, uint8_t *row) {
+    uint32_t bytes = bitmap_getRowBytes(bitmap);
+
+    bitmap_renderBytes(bitmap, y, 0, bytes, row);
+
+    if (format == QRCODE_IMAGE_BMP) {
+        memset(row + bytes, 0, rowBytes - bytes);
+    } else if (format == QRCODE_IMAGE_PGM) {
+        for (uint32_t i = bytes; i-- > 0;) {
+            uint8_t value = row[i];
+            uint32_t count = width - i * 8 < 8 ? width - i * 8 : 8;
+
+            for (uint32_t j = 0; j < count; j++) { row[i * 8 + j] = (value & (0x80 >> j)) ? 0x00 : 0xff; }
+        }
+    }
+}
+
+
+#pragma mark - Display Output
+
+// Monochrome OLED controllers (SSD1306, SH1106) store the display in pages of 8 pixel rows,
+// one byte per column with the top row in the least significant bit.  Each page is rendered
+// as 8 ordinary rows of bits and turned into columns with an 8x8 transpose.
+
+// Transposes an 8x8 bit block: row i of "in" (most significant bit on the left) becomes bit
+// i of each column in "out".
+static void page_transpose8(const uint8_t *in, uint8_t *out) {
+    uint64_t x = 0;
+
+    for (uint8_t i = 0; i < 8; i++) { x |= (uint64_t)in[i] << (8 * i); }
+
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+    x = x ^ t ^ (t << 28);
+
+    for (uint8_t i = 0; i < 8; i++) { out[i] = (uint8_t)(x >> (56 - 8 * i)); }
+}
+
+// Renders pixel row "row" of the bordered symbol into "bits", covering display columns
+// [x0, x1) with the symbol's left edge at display column x.
+static void page_renderRow(QRCode *qrcode, int32_t row, int32_t x, uint8_t scale, uint8_t border, int32_t x0, int32_t x1, uint8_t *bits) {
+    int32_t y = row / scale - border;
+
+    memset(bits, 0, (size_t)((x1 + 7) / 8));
+    if (y < 0 || y >= qrcode->size) { return; }
+
+    QRCodeRunCursor cursor;
+    uint8_t start, length;
+
+    qrcode_runBegin(&cursor, QRCODE_RUN_ROWS, (uint8_t)y);
+    while (qrcode_nextRun(qrcode, &cursor, &start, &length) && cursor.line == y) {
+        int32_t left = x + ((int32_t)border + start) * scale, right = left + (int32_t)length * scale;
+        if (left < x0) { left = x0; }
+        if (right > x1) { right = x1; }
+        if (left < right) { raw_setBits(bits, (uint32_t)left, (uint32_t)right); }
+    }
+}
+
+
+#pragma mark - Frame Buffer Output
+
+// Color frame buffers get one line per module row, expanded from the packed module bits; the
+// other lines of the module row are copies of it.
+
+#define BLIT_TABLE_SCALE    8       // Largest scale * bytes per pixel expanded through a table
+
+// Builds the table of pixels for each pattern of 4 modules at the given scale.
+static void blit_buildTable(uint8_t table[16][4 * BLIT_TABLE_SCALE], uint8_t format, uint8_t scale, uint32_t fg, uint32_t bg) {
+    uint16_t fg16 = (uint16_t)fg, bg16 = (uint16_t)bg;
+
+    for (uint8_t n = 0; n < 16; n++) {
+        uint8_t *ptr = table[n];
+
+        for (uint8_t i = 0; i < 4 * scale; i++) {
+            bool dark = (n & (8 >> (i / scale))) != 0;
+
+            if (format == QRCODE_PIXEL_RGB565) {
+                memcpy(ptr, dark ? &fg16 : &bg16, 2);
+                ptr += 2;
+            } else {
+                memcpy(ptr, dark ? &fg : &bg, 4);
+                ptr += 4;
+            }
+        }
+    }
+}
+
+// Renders module row y into display columns [x0, x1) of "line", with the symbol's left
+// edge at display column x.  Small scales copy 4 modules at a time from a table; otherwise
+// each module's color is selected with a mask rather than a branch, since module values are
+// close to random in the data area.
+static void blit_renderLine(QRCode *qrcode, uint8_t y, int32_t x, uint8_t scale, int32_t x0, int32_t x1, uint8_t format, uint32_t fg, uint32_t bg, uint8_t table[16][4 * BLIT_TABLE_SCALE], uint8_t *line) {
+    uint8_t bits[(qrcode->size + 7) / 8];
+    uint8_t bpp = format == QRCODE_PIXEL_RGB565 ? 2 : 4;
+    uint8_t first = (uint8_t)((x0 - x) / scale), last = (uint8_t)((x1 - 1 - x) / scale);
+    bool useTable = scale * bpp <= BLIT_TABLE_SCALE;
+    uint32_t diff = fg ^ bg;
+    int32_t px = x0;
+
+    bitmap_getRowBits(qrcode, y, bits);
+
+    for (uint16_t mx = first; mx <= last; mx++) {
+        // Whole groups of 4 visible modules come from the table...
+        if (useTable && (mx & 3) == 0 && px == x + (int32_t)mx * scale) {
+            for (; mx + 4 <= last; mx += 4, px += 4 * scale) {
+                uint8_t *dest = line + (size_t)px * bpp, *src = table[(bits[mx >> 3] >> (4 - (mx & 4))) & 15];
+
+                // Constant sizes, so the copies are inlined...
+                switch (scale * bpp) {
+                    case 2 :  memcpy(dest, src, 8); break;
+                    case 4 :  memcpy(dest, src, 16); break;
+                    case 6 :  memcpy(dest, src, 24); break;
+                    default : memcpy(dest, src, 32); break;
+                }
+            }
+        }
+
+        uint32_t color = bg ^ (diff & (0u - (uint32_t)((bits[mx >> 3] >> (7 - (mx & 7))) & 1)));
+        int32_t end = x + ((int32_t)mx + 1) * scale;
+
+        if (end > x1) { end = x1; }
+
+        if (format == QRCODE_PIXEL_RGB565) {
+            for (uint16_t *pixel = (uint16_t *)line; px < end; px++) { pixel[px] = (uint16_t)color; }
+        } else {
+            for (uint32_t *pixel = (uint32_t *)line; px < end; px++) { pixel[px] = color; }
+        }
+    }
+}
+
+
+#pragma mark - Buffered Text Output
+
+// Text formats are written through a small buffer, so the callback sees a few large writes
+// instead of one per number or command.
+
+#define OUTPUT_BUFSIZE      256
+
+typedef struct OutputBuffer {
+    QRCodeWriteCallback cb;
+    void *ctx;
+    bool ok;                    // false after a write error
+    uint32_t offset;            // Bytes passed to the callback so far
+    size_t length;              // Bytes used in buffer
+    char buffer[OUTPUT_BUFSIZE];
+} OutputBuffer;
+
+// Sink for passes that only measure the output.
+static bool out_discard(void *ctx, const uint8_t *data, size_t length) {
+    (void)ctx;
+    (void)data;
+    (void)length;
+    return true;
+}
+
+static void out_begin(OutputBuffer *out, QRCodeWriteCallback cb, void *ctx) {
+    out->cb = cb;
+    out->ctx = ctx;
+    out->ok = true;
+    out->offset = 0;
+    out->length = 0;
+}
+
+static void out_flush(OutputBuffer *out) {
+    if (out->length > 0 && out->ok) {
+        out->ok = (out->cb)(out->ctx, (const uint8_t *)out->buffer, out->length);
+    }
+    out->offset += out->length;
+    out->length = 0;
+}
+
+// Writes binary data, bypassing the buffer.
+static void out_write(OutputBuffer *out, const uint8_t *data, size_t length) {
+    out_flush(out);
+    if (out->ok) { out->ok = (out->cb)(out->ctx, data, length); }
+    out->offset += length;
+}
+
+static void out_putc(OutputBuffer *out, char ch) {
+    out->buffer[out->length++] = ch;
+    if (out->length == sizeof(out->buffer)) { out_flush(out); }
+}
+
+static void out_puts(OutputBuffer *out, const char *s) {
+    while (*s) { out_putc(out, *s++); }
+}
+
+// Formats a signed integer without going through printf.
+static void out_putInt(OutputBuffer *out, int32_t value) {
+    char temp[11], *ptr = temp;
+    uint32_t uvalue = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+
+    if (value < 0) { out_putc(out, '-'); }
+    do {
+        *ptr++ = (char)('0' + uvalue % 10);
+        uvalue /= 10;
+    } while (uvalue > 0);
+
+    while (ptr > temp) { out_putc(out, *--ptr); }
+}
+
+// Formats a value in thousandths with three decimals.
+static void out_putFixed(OutputBuffer *out, int32_t value) {
+    if (value < 0) {
+        out_putc(out, '-');
+        value = -value;
+    }
+    out_putInt(out, value / 1000);
+    out_putc(out, '.');
+    out_putc(out, (char)('0' + value / 100 % 10));
+    out_putc(out, (char)('0' + value / 10 % 10));
+    out_putc(out, (char)('0' + value % 10));
+}
+
+// Renders a bitmap row for module row y straight into the buffer.
+static void out_putBitmap(OutputBuffer *out, BitmapRenderer *bitmap, int16_t y) {
+    uint32_t rowBytes = bitmap_getRowBytes(bitmap);
+
+    for (uint32_t x = 0; x < rowBytes;) {
+        uint32_t count = rowBytes - x;
+        if (count > sizeof(out->buffer) - out->length) { count = (uint32_t)(sizeof(out->buffer) - out->length); }
+
+        bitmap_renderBytes(bitmap, y, x, count, (uint8_t *)out->buffer + out->length);
+        out->length += count;
+        x += count;
+
+        if (out->length == sizeof(out->buffer)) { out_flush(out); }
+    }
+}
+
+static bool out_finish(OutputBuffer *out) {
+    out_flush(out);
+    return out->ok;
+}
+
+
+#pragma mark - SVG Output
+
+// The finder and alignment patterns are defined once and placed with <use>.  Holes are drawn
+// counter-clockwise so the default nonzero fill rule leaves them empty.
+static const char SVG_DEFS[] =
+    "<defs><path id=\"f\" d=\"M0 0h7v7h-7zm1 1v5h5v-5zm1 1h3v3h-3z\"/>"
+    "<path id=\"a\" d=\"M0 0h5v5h-5zm1 1v3h3v-3zm1 1h1v1h-1z\"/></defs>\n";
+
+// Appends a number to a path, with a separator only when the sign doesn't provide one.
+static void svg_putPathInt(OutputBuffer *out, int32_t value, bool separator) {
+    if (separator && value >= 0) { out_putc(out, ' '); }
+    out_putInt(out, value);
+}
+
+// Writes the <svg> element and white background; the image is drawn in modules and
+// scaled to pixels by the viewBox.
+static void svg_putHeader(OutputBuffer *out, int32_t width, int32_t height, uint8_t scale) {
+    out_puts(out, "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"");
+    out_putInt(out, width * scale);
+    out_puts(out, "\" height=\"");
+    out_putInt(out, height * scale);
+    out_puts(out, "\" viewBox=\"0 0 ");
+    out_putInt(out, width);
+    out_putc(out, ' ');
+    out_putInt(out, height);
+    out_puts(out, "\" shape-rendering=\"crispEdges\">\n");
+    out_puts(out, "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n");
+}
+
+static void svg_putUse(OutputBuffer *out, char id, int32_t x, int32_t y) {
+    out_puts(out, "<use xlink:href=\"#");
+    out_putc(out, id);
+    out_puts(out, "\" x=\"");
+    out_putInt(out, x);
+    out_puts(out, "\" y=\"");
+    out_putInt(out, y);
+    out_puts(out, "\"/>\n");
+}
+
+// Writes one symbol whose top-left module is at (ox, oy) in the drawing.
+static void svg_writeSymbol(OutputBuffer *out, QRCode *qrcode, int32_t ox, int32_t oy) {
+    uint8_t size = qrcode->size;
+    QRCodeRectCursor cursor;
+    QRCodeRect rect;
+
+    // The patterns are only placed with <use> when they are where the definitions expect
+    // them; after a transform the rectangles cover them too
+    qrcode_rectsBegin(qrcode, &cursor, QRCODE_COVER_DATA);
+
+    if (cursor.options & QRCODE_COVER_DATA) {
+        svg_putUse(out, 'f', ox, oy);
+        svg_putUse(out, 'f', ox + size - 7, oy);
+        svg_putUse(out, 'f', ox, oy + size - 7);
+
+        for (uint8_t i = 0; i < cursor.alignCount; i++) {
+            for (uint8_t j = 0; j < cursor.alignCount; j++) {
+                if ((i == 0 && j == 0) || (i == 0 && j == cursor.alignCount - 1) || (i == cursor.alignCount - 1 && j == 0)) { continue; }
+                svg_putUse(out, 'a', ox + cursor.align[i] - 2, oy + cursor.align[j] - 2);
+            }
+        }
+    }
+
+    // The remaining dark modules are covered by rectangles in a single path; "z" returns
+    // to the corner of the rectangle, so each "m" is relative to the previous one...
+    int32_t lastX = 0, lastY = 0;
+    bool first = true;
+
+    out_puts(out, "<path d=\"");
+
+    while (qrcode_nextRect(qrcode, &cursor, &rect)) {
+        if (first) {
+            out_putc(out, 'M');
+            svg_putPathInt(out, ox + rect.x, false);
+            svg_putPathInt(out, oy + rect.y, true);
+            first = false;
+        } else {
+            out_putc(out, 'm');
+            svg_putPathInt(out, rect.x - lastX, false);
+            svg_putPathInt(out, rect.y - lastY, true);
+        }
+        out_putc(out, 'h');
+        out_putInt(out, rect.width);
+        out_putc(out, 'v');
+        out_putInt(out, rect.height);
+        out_putc(out, 'h');
+        out_putInt(out, -rect.width);
+        out_putc(out, 'z');
+
+        lastX = rect.x;
+        lastY = rect.y;
+    }
+
+    out_puts(out, "\"/>\n");
+}
+
+
+#pragma mark - PostScript Output
+
+// Dark modules are covered by rectangles, each written as a few numbers and a one letter
+// procedure: "x y w R" for a rectangle one module high and "x y w h B" otherwise.  The
+// coordinates are in modules from the top-left corner of the symbol.
+
+static const char EPS_PROLOG[] =
+    "/R{1 rectfill}bind def\n"
+    "/B{rectfill}bind def\n";
+
+static void eps_writeSymbol(OutputBuffer *out, QRCode *qrcode) {
+    QRCodeRectCursor cursor;
+    QRCodeRect rect;
+
+    qrcode_rectsBegin(qrcode, &cursor, QRCODE_COVER_ALL);
+    while (qrcode_nextRect(qrcode, &cursor, &rect)) {
+        out_putInt(out, rect.x);
+        out_putc(out, ' ');
+        out_putInt(out, rect.y);
+        out_putc(out, ' ');
+        out_putInt(out, rect.width);
+        if (rect.height == 1) {
+            out_puts(out, " R\n");
+        } else {
+            out_putc(out, ' ');
+            out_putInt(out, rect.height);
+            out_puts(out, " B\n");
+        }
+    }
+}
+
+
+#pragma mark - TIFF Output
+
+// Group 4 (T.6) fax coding codes each row against the row above, by the positions where the
+// color changes.  Since a scaled module row repeats "scale" times, all but the first copy
+// cost one bit per change.  The changes are computed from the module runs, so no pixel rows
+// are ever built.
+
+#define TIFF_DPI            300     // Resolution written to the file
+
+typedef struct G4Code {
+    uint16_t code;
+    uint8_t length;
+} G4Code;
+
+// White run lengths 0 to 63
+static const G4Code G4_WHITE_TERM[64] = {
+    { 0x0035,  8 }, { 0x0007,  6 }, { 0x0007,  4 }, { 0x0008,  4 },
+    { 0x000b,  4 }, { 0x000c,  4 }, { 0x000e,  4 }, { 0x000f,  4 },
+    { 0x0013,  5 }, { 0x0014,  5 }, { 0x0007,  5 }, { 0x0008,  5 },
+    { 0x0008,  6 }, { 0x0003,  6 }, { 0x0034,  6 }, { 0x0035,  6 },
+    { 0x002a,  6 }, { 0x002b,  6 }, { 0x0027,  7 }, { 0x000c,  7 },
+    { 0x0008,  7 }, { 0x0017,  7 }, { 0x0003,  7 }, { 0x0004,  7 },
+    { 0x0028,  7 }, { 0x002b,  7 }, { 0x0013,  7 }, { 0x0024,  7 },
+    { 0x0018,  7 }, { 0x0002,  8 }, { 0x0003,  8 }, { 0x001a,  8 },
+    { 0x001b,  8 }, { 0x0012,  8 }, { 0x0013,  8 }, { 0x0014,  8 },
+    { 0x0015,  8 }, { 0x0016,  8 }, { 0x0017,  8 }, { 0x0028,  8 },
+    { 0x0029,  8 }, { 0x002a,  8 }, { 0x002b,  8 }, { 0x002c,  8 },
+    { 0x002d,  8 }, { 0x0004,  8 }, { 0x0005,  8 }, { 0x000a,  8 },
+    { 0x000b,  8 }, { 0x0052,  8 }, { 0x0053,  8 }, { 0x0054,  8 },
+    { 0x0055,  8 }, { 0x0024,  8 }, { 0x0025,  8 }, { 0x0058,  8 },
+    { 0x0059,  8 }, { 0x005a,  8 }, { 0x005b,  8 }, { 0x004a,  8 },
+    { 0x004b,  8 }, { 0x0032,  8 }, { 0x0033,  8 }, { 0x0034,  8 }
+};
+
+// White run lengths 64 to 1728, in steps of 64
+static const G4Code G4_WHITE_MAKEUP[27] = {
+    { 0x001b,  5 }, { 0x0012,  5 }, { 0x0017,  6 }, { 0x0037,  7 },
+    { 0x0036,  8 }, { 0x0037,  8 }, { 0x0064,  8 }, { 0x0065,  8 },
+    { 0x0068,  8 }, { 0x0067,  8 }, { 0x00cc,  9 }, { 0x00cd,  9 },
+    { 0x00d2,  9 }, { 0x00d3,  9 }, { 0x00d4,  9 }, { 0x00d5,  9 },
+    { 0x00d6,  9 }, { 0x00d7,  9 }, { 0x00d8,  9 }, { 0x00d9,  9 },
+    { 0x00da,  9 }, { 0x00db,  9 }, { 0x0098,  9 }, { 0x0099,  9 },
+    { 0x009a,  9 }, { 0x0018,  6 }, { 0x009b,  9 }
+};
+
+// Black run lengths 0 to 63
+static const G4Code G4_BLACK_TERM[64] = {
+    { 0x0037, 10 }, { 0x0002,  3 }, { 0x0003,  2 }, { 0x0002,  2 },
+    { 0x0003,  3 }, { 0x0003,  4 }, { 0x0002,  4 }, { 0x0003,  5 },
+    { 0x0005,  6 }, { 0x0004,  6 }, { 0x0004,  7 }, { 0x0005,  7 },
+    { 0x0007,  7 }, { 0x0004,  8 }, { 0x0007,  8 }, { 0x0018,  9 },
+    { 0x0017, 10 }, { 0x0018, 10 }, { 0x0008, 10 }, { 0x0067, 11 },
+    { 0x0068, 11 }, { 0x006c, 11 }, { 0x0037, 11 }, { 0x0028, 11 },
+    { 0x0017, 11 }, { 0x0018, 11 }, { 0x00ca, 12 }, { 0x00cb, 12 },
+    { 0x00cc, 12 }, { 0x00cd, 12 }, { 0x0068, 12 }, { 0x0069, 12 },
+    { 0x006a, 12 }, { 0x006b, 12 }, { 0x00d2, 12 }, { 0x00d3, 12 },
+    { 0x00d4, 12 }, { 0x00d5, 12 }, { 0x00d6, 12 }, { 0x00d7, 12 },
+    { 0x006c, 12 }, { 0x006d, 12 }, { 0x00da, 12 }, { 0x00db, 12 },
+    { 0x0054, 12 }, { 0x0055, 12 }, { 0x0056, 12 }, { 0x0057, 12 },
+    { 0x0064, 12 }, { 0x0065, 12 }, { 0x0052, 12 }, { 0x0053, 12 },
+    { 0x0024, 12 }, { 0x0037, 12 }, { 0x0038, 12 }, { 0x0027, 12 },
+    { 0x0028, 12 }, { 0x0058, 12 }, { 0x0059, 12 }, { 0x002b, 12 },
+    { 0x002c, 12 }, { 0x005a, 12 }, { 0x0066, 12 }, { 0x0067, 12 }
+};
+
+// Black run lengths 64 to 1728, in steps of 64
+static const G4Code G4_BLACK_MAKEUP[27] = {
+    { 0x000f, 10 }, { 0x00c8, 12 }, { 0x00c9, 12 }, { 0x005b, 12 },
+    { 0x0033, 12 }, { 0x0034, 12 }, { 0x0035, 12 }, { 0x006c, 13 },
+    { 0x006d, 13 }, { 0x004a, 13 }, { 0x004b, 13 }, { 0x004c, 13 },
+    { 0x004d, 13 }, { 0x0072, 13 }, { 0x0073, 13 }, { 0x0074, 13 },
+    { 0x0075, 13 }, { 0x0076, 13 }, { 0x0077, 13 }, { 0x0052, 13 },
+    { 0x0053, 13 }, { 0x0054, 13 }, { 0x0055, 13 }, { 0x005a, 13 },
+    { 0x005b, 13 }, { 0x0064, 13 }, { 0x0065, 13 }
+};
+
+// Run lengths 1792 to 2560 for either color, in steps of 64
+static const G4Code G4_EXT_MAKEUP[13] = {
+    { 0x0008, 11 }, { 0x000c, 11 }, { 0x000d, 11 }, { 0x0012, 12 },
+    { 0x0013, 12 }, { 0x0014, 12 }, { 0x0015, 12 }, { 0x0016, 12 },
+    { 0x0017, 12 }, { 0x001c, 12 }, { 0x001d, 12 }, { 0x001e, 12 },
+    { 0x001f, 12 }
+};
+
+typedef struct G4Output {
+    OutputBuffer out;
+    uint32_t bits;              // Pending output bits, MSB first
+    uint8_t bitCount;
+} G4Output;
+
+// Appends up to 16 bits, most significant bit first.
+static void g4_putBits(G4Output *g4, uint16_t code, uint8_t length) {
+    g4->bits = (g4->bits << length) | code;
+    g4->bitCount += length;
+    while (g4->bitCount >= 8) {
+        g4->bitCount -= 8;
+        out_putc(&g4->out, (char)(g4->bits >> g4->bitCount));
+    }
+    g4->bits &= (1u << g4->bitCount) - 1;
+}
+
+static void g4_putRun(G4Output *g4, uint32_t length, bool black) {
+    const G4Code *code;
+
+    while (length >= 2560) {
+        g4_putBits(g4, G4_EXT_MAKEUP[12].code, G4_EXT_MAKEUP[12].length);
+        length -= 2560;
+    }
+    if (length >= 1792) {
+        code = G4_EXT_MAKEUP + (length - 1792) / 64;
+        g4_putBits(g4, code->code, code->length);
+    } else if (length >= 64) {
+        code = (black ? G4_BLACK_MAKEUP : G4_WHITE_MAKEUP) + length / 64 - 1;
+        g4_putBits(g4, code->code, code->length);
+    }
+
+    code = (black ? G4_BLACK_TERM : G4_WHITE_TERM) + length % 64;
+    g4_putBits(g4, code->code, code->length);
+}
+
+// Stores the pixel columns where the colors change in one row, starting with white, and
+// returns how many there are.
+static uint16_t g4_getChanges(QRCode *qrcode, uint8_t y, uint8_t scale, uint8_t border, uint32_t width, uint32_t *changes) {
+    QRCodeRunCursor cursor;
+    uint16_t count = 0;
+    uint8_t x, length;
+
+    qrcode_runBegin(&cursor, QRCODE_RUN_ROWS, y);
+    while (qrcode_nextRun(qrcode, &cursor, &x, &length) && cursor.line == y) {
+        changes[count++] = ((uint32_t)border + x) * scale;
+        if (((uint32_t)border + x + length) * scale < width) { changes[count++] = ((uint32_t)border + x + length) * scale; }
+    }
+
+    return count;
+}
+
+// Codes one row given its changes and those of the row above (T.6 section 2.2).
+static void g4_putRow(G4Output *g4, const uint32_t *ref, uint16_t refCount, const uint32_t *cur, uint16_t curCount, uint32_t width) {
+    int32_t a0 = -1;
+    bool black = false;
+    uint16_t i = 0, k = 0;
+
+    while (a0 < (int32_t)width) {
+        // a1, a2 are the next changes on this row; b1 is the next change on the row above
+        // to the color opposite a0, and b2 the one after it
+        while (i < curCount && (int32_t)cur[i] <= a0) { i++; }
+        while (k < refCount && (int32_t)ref[k] <= a0) { k++; }
+
+        uint16_t j = k + ((k & 1) != black);
+        uint32_t a1 = i < curCount ? cur[i] : width, a2 = i + 1 < curCount ? cur[i + 1] : width;
+        uint32_t b1 = j < refCount ? ref[j] : width, b2 = j + 1 < refCount ? ref[j + 1] : width;
+
+        if (b2 < a1) {
+            // Pass mode
+            g4_putBits(g4, 0x1, 4);
+            a0 = (int32_t)b2;
+        } else if (a1 + 3 >= b1 && a1 <= b1 + 3) {
+            // Vertical mode: 1, 011/010, 000011/000010, 0000011/0000010
+            static const G4Code vertical[7] = {
+                { 0x02, 7 }, { 0x02, 6 }, { 0x02, 3 }, { 0x01, 1 }, { 0x03, 3 }, { 0x03, 6 }, { 0x03, 7 }
+            };
+            const G4Code *code = vertical + 3 + (int32_t)(a1 - b1);
+            g4_putBits(g4, code->code, code->length);
+            a0 = (int32_t)a1;
+            black = !black;
+        } else {
+            // Horizontal mode
+            g4_putBits(g4, 0x1, 3);
+            g4_putRun(g4, a1 - (a0 < 0 ? 0 : (uint32_t)a0), black);
+            g4_putRun(g4, a2 - a1, !black);
+            a0 = (int32_t)a2;
+        }
+    }
+}
+
+// Codes the whole image; returns the number of bytes.
+static uint32_t g4_writeImage(G4Output *g4, QRCode *qrcode, uint8_t scale, uint8_t border, uint32_t width) {
+    uint32_t ref[qrcode->size + 1], cur[qrcode->size + 1];
+    uint16_t refCount = 0, curCount = 0;
+    uint32_t start = g4->out.offset + (uint32_t)g4->out.length;
+
+    g4->bits = 0;
+    g4->bitCount = 0;
+
+    // The top quiet zone is all white like the imaginary row above the image, so each of
+    // its rows is just one V0 code...
+    for (uint32_t row = 0; row < (uint32_t)border * scale; row++) { g4_putBits(g4, 1, 1); }
+
+    for (uint8_t y = 0; y < qrcode->size; y++) {
+        curCount = g4_getChanges(qrcode, y, scale, border, width, cur);
+        g4_putRow(g4, ref, refCount, cur, curCount, width);
+
+        // ...and the copies of a row are one V0 per change, plus one for the end of the row
+        for (uint8_t copy = 1; copy < scale; copy++) {
+            for (uint16_t n = curCount + 1; n > 0; n -= n > 16 ? 16 : n) {
+                uint8_t bits = n > 16 ? 16 : (uint8_t)n;
+                g4_putBits(g4, (uint16_t)((1u << bits) - 1), bits);
+            }
+        }
+
+        memcpy(ref, cur, curCount * sizeof(uint32_t));
+        refCount = curCount;
+    }
+
+    if (border > 0) {
+        g4_putRow(g4, ref, refCount, cur, 0, width);
+        for (uint32_t row = 1; row < (uint32_t)border * scale; row++) { g4_putBits(g4, 1, 1); }
+    }
+
+    // End of facsimile block (two EOLs), padded to a byte
+    g4_putBits(g4, 0x001, 12);
+    g4_putBits(g4, 0x001, 12);
+    if (g4->bitCount > 0) { g4_putBits(g4, 0, 8 - g4->bitCount); }
+
+    return g4->out.offset + (uint32_t)g4->out.length - start;
+}
+
+static void tiff_putShort(OutputBuffer *out, uint16_t value) {
+    out_putc(out, (char)value);
+    out_putc(out, (char)(value >> 8));
+}
+
+static void tiff_putLong(OutputBuffer *out, uint32_t value) {
+    tiff_putShort(out, (uint16_t)value);
+    tiff_putShort(out, (uint16_t)(value >> 16));
+}
+
+// Writes a 12 byte IFD entry with a single SHORT (3), LONG (4) or RATIONAL (5) offset value.
+static void tiff_putEntry(OutputBuffer *out, uint16_t tag, uint16_t type, uint32_t value) {
+    tiff_putShort(out, tag);
+    tiff_putShort(out, type);
+    tiff_putLong(out, 1);
+    if (type == 3) {
+        tiff_putShort(out, (uint16_t)value);
+        tiff_putShort(out, 0);
+    } else {
+        tiff_putLong(out, value);
+    }
+}
+
+
+#pragma mark - ESC/POS Output
+
+// Receipt printers take raster images in bands: "GS v 0" blocks of up to ESCPOS_BAND_BYTES,
+// or "ESC *" lines of 24 dots with the line spacing set to match.  Each band is flushed to
+// the callback as soon as it is complete, so the printer can start before the rest of the
+// symbol has been rendered.  Pixels are produced straight from the modules; nothing larger
+// than the output buffer is held in memory.
+
+#define ESCPOS_BAND_BYTES   1024    // Fits the receive buffer of common receipt printers
+#define ESCPOS_MAX_DOTS     65535   // Largest width/height the commands can express
+
+static void escpos_putCommand(OutputBuffer *out, const char *command, size_t length) {
+    while (length-- > 0) { out_putc(out, *command++); }
+}
+
+static void escpos_putShort(OutputBuffer *out, uint32_t value) {
+    out_putc(out, (char)(value & 0xff));
+    out_putc(out, (char)(value >> 8));
+}
+
+// GS v 0 m xL xH yL yH: raster bit image, one command per band of rows.
+static void escpos_writeRaster(OutputBuffer *out, QRCode *qrcode, uint8_t scale, uint8_t border, uint32_t width) {
+    BitmapRenderer bitmap;
+    bitmap_begin(&bitmap, qrcode, scale, border);
+
+    uint32_t rowBytes = bitmap_getRowBytes(&bitmap);
+    uint32_t bandRows = rowBytes < ESCPOS_BAND_BYTES ? ESCPOS_BAND_BYTES / rowBytes : 1;
+
+    for (uint32_t row = 0; row < width; row += bandRows) {
+        uint32_t rows = width - row < bandRows ? width - row : bandRows;
+
+        escpos_putCommand(out, "\x1dv0\0", 4);
+        escpos_putShort(out, rowBytes);
+        escpos_putShort(out, rows);
+
+        for (uint32_t r = row; r < row + rows; r++) { out_putBitmap(out, &bitmap, (int16_t)(r / scale - border)); }
+        out_flush(out);
+    }
+}
+
+// ESC * 33 nL nH: 24 dot double density bit image, 3 bytes per column, one line per band.
+// The rows of a band come from at most 24 module rows, so each module column is looked up
+// once per module row and repeated for the columns of its scale.
+static void escpos_writeColumns(OutputBuffer *out, QRCode *qrcode, uint8_t scale, uint8_t border, uint32_t width) {
+    uint32_t columns[qrcode->size];
+
+    escpos_putCommand(out, "\x1b" "3\x18", 3);      // ESC 3 24: 24 dot line spacing
+
+    for (uint32_t row = 0; row < width; row += 24) {
+        int32_t modRows[24];
+        uint32_t masks[24];
+        uint8_t count = 0;
+
+        // Group the dots of this band by module row...
+        for (uint8_t i = 0; i < 24 && row + i < width; i++) {
+            int32_t y = (int32_t)((row + i) / scale) - border;
+            if (y < 0 || y >= qrcode->size) { continue; }
+
+            if (count == 0 || modRows[count - 1] != y) {
+                modRows[count] = y;
+                masks[count++] = 0;
+            }
+            masks[count - 1] |= 0x800000u >> i;
+        }
+
+        // ...and set those dots in the columns under each dark run
+        memset(columns, 0, sizeof(columns));
+        for (uint8_t i = 0; i < count; i++) {
+            QRCodeRunCursor cursor;
+            uint8_t x, length;
+
+            qrcode_runBegin(&cursor, QRCODE_RUN_ROWS, (uint8_t)modRows[i]);
+            while (qrcode_nextRun(qrcode, &cursor, &x, &length) && cursor.line == modRows[i]) {
+                while (length-- > 0) { columns[x++] |= masks[i]; }
+            }
+        }
+
+        escpos_putCommand(out, "\x1b*!", 3);
+        escpos_putShort(out, width);
+
+        for (int32_t x = -(int32_t)border; x < qrcode->size + border; x++) {
+            uint32_t column = x >= 0 && x < qrcode->size ? columns[x] : 0;
+
+            for (uint8_t copy = 0; copy < scale; copy++) {
+                out_putc(out, (char)(column >> 16));
+                out_putc(out, (char)(column >> 8));
+                out_putc(out, (char)column);
+            }
+        }
+
+        out_putc(out, '\n');
+        out_flush(out);
+    }
+
+    escpos_putCommand(out, "\x1b" "2", 2);          // ESC 2: default line spacing
+}
+
+
+#pragma mark - ZPL Output
+
+// Zebra printers take "^GFA" graphic fields as hex rows, which ZPL compresses with repeat
+// counts: "G" to "Y" for 1 to 19 and "g" to "z" for 20 to 400 in steps of 20, placed before
+// the repeated digit.  A row ending in zeros (or ones) is cut short with "," (or "!") and a
+// row matching the one above is just ":", which covers the copies of each module row and
+// the quiet zone.
+
+typedef struct ZPLOutput {
+    OutputBuffer out;
+    BitmapRenderer bitmap;
+    uint8_t digit;              // Hex digit being repeated
+    uint32_t repeat;            // Number of times it repeats
+} ZPLOutput;
+
+static void zpl_putRepeat(ZPLOutput *zpl) {
+    static const char hex[] = "0123456789ABCDEF";
+    uint32_t repeat = zpl->repeat;
+
+    while (repeat > 400) {
+        out_putc(&zpl->out, 'z');
+        out_putc(&zpl->out, hex[zpl->digit]);
+        repeat -= 400;
+    }
+    if (repeat >= 20) { out_putc(&zpl->out, (char)('f' + repeat / 20)); }
+    if (repeat % 20 > 0 && repeat > 1) { out_putc(&zpl->out, (char)('F' + repeat % 20)); }
+    out_putc(&zpl->out, hex[zpl->digit]);
+
+    zpl->repeat = 0;
+}
+
+static void zpl_putDigit(ZPLOutput *zpl, uint8_t digit) {
+    if (zpl->repeat > 0 && zpl->digit != digit) { zpl_putRepeat(zpl); }
+    zpl->digit = digit;
+    zpl->repeat++;
+}
+
+// Writes module row y from its bitmap, a piece at a time.
+static void zpl_putRow(ZPLOutput *zpl, uint8_t y) {
+    uint32_t rowBytes = bitmap_getRowBytes(&zpl->bitmap);
+    uint8_t bytes[32];
+
+    for (uint32_t x = 0; x < rowBytes; x += sizeof(bytes)) {
+        uint32_t count = rowBytes - x < sizeof(bytes) ? rowBytes - x : (uint32_t)sizeof(bytes);
+
+        bitmap_renderBytes(&zpl->bitmap, y, x, count, bytes);
+        for (uint32_t i = 0; i < count; i++) {
+            zpl_putDigit(zpl, bytes[i] >> 4);
+            zpl_putDigit(zpl, bytes[i] & 15);
+        }
+    }
+
+    // Trailing zeros or ones are implied by the row terminator...
+    if (zpl->digit == 0x0) {
+        out_putc(&zpl->out, ',');
+    } else if (zpl->digit == 0xf) {
+        out_putc(&zpl->out, '!');
+    } else {
+        zpl_putRepeat(zpl);
+    }
+    zpl->repeat = 0;
+}
+
+// Rows are equal when they have the same runs.
+static bool zpl_rowsEqual(QRCode *qrcode, uint8_t a, uint8_t b) {
+    QRCodeRunCursor cursorA, cursorB;
+    uint8_t xA, lengthA, xB, lengthB;
+
+    qrcode_runBegin(&cursorA, QRCODE_RUN_ROWS, a);
+    qrcode_runBegin(&cursorB, QRCODE_RUN_ROWS, b);
+
+    for (;;) {
+        bool moreA = qrcode_nextRun(qrcode, &cursorA, &xA, &lengthA) && cursorA.line == a;
+        bool moreB = qrcode_nextRun(qrcode, &cursorB, &xB, &lengthB) && cursorB.line == b;
+
+        if (moreA != moreB) { return false; }
+        if (!moreA) { return true; }
+        if (xA != xB || lengthA != lengthB) { return false; }
+    }
+}
+
+
+#pragma mark - Terminal Output
+
+// Terminal text packs two module rows into each line with the half block characters, so a
+// module is one character wide and half a line tall, which is close to square in most fonts.
+
+static const char * const TEXT_BLOCKS[4] = {
+    " ",                        // Neither
+    "\xe2\x96\x84",              // U+2584 LOWER HALF BLOCK
+    "\xe2\x96\x80",              // U+2580 UPPER HALF BLOCK
+    "\xe2\x96\x88"               // U+2588 FULL BLOCK
+};
+
+// Marks the dark modules of row y (if it is in the symbol) with "bit" in each cell of a
+// line, where cells[0] is the left edge of the quiet zone.
+static void text_markRow(QRCode *qrcode, int16_t y, uint8_t border, uint8_t bit, uint8_t *cells) {
+    QRCodeRunCursor cursor;
+    uint8_t x, length;
+
+    if (y < 0 || y >= qrcode->size) { return; }
+
+    qrcode_runBegin(&cursor, QRCODE_RUN_ROWS, (uint8_t)y);
+    while (qrcode_nextRun(qrcode, &cursor, &x, &length) && cursor.line == y) {
+        for (uint8_t *cell = cells + border + x; length > 0; length--) { *cell++ |= bit; }
+    }
+}
+
+
+#pragma mark - Outline Output
+
+// The outline writers share one contour callback; each format emits MOVE/LINE/CLOSE
+// commands in its own syntax.
+
+typedef enum {
+    OUTLINE_SVG,                // Relative SVG path data
+    OUTLINE_POLYLINE,           // One "x,y x,y ..." line per outline
+    OUTLINE_GCODE               // G0/G1 moves with the laser switched by M3/M5
+} OutlineFormat;
+
+typedef struct OutlineOutput {
+    OutputBuffer out;
+    OutlineFormat format;
+    int32_t ox, oy;             // Origin of the symbol (SVG)
+    uint8_t size;               // Symbol size (G-code Y axis points up)
+    uint16_t pitch;             // Module pitch in micrometres (G-code)
+    uint16_t feed;              // Feed rate in mm/min, sent with the first G1 (G-code)
+    bool first;                 // No outline written yet
+    uint8_t x, y;               // Current point
+} OutlineOutput;
+
+static void gcode_putPoint(OutlineOutput *outline, const char *command, uint8_t x, uint8_t y) {
+    out_puts(&outline->out, command);
+    out_puts(&outline->out, " X");
+    out_putFixed(&outline->out, (int32_t)x * outline->pitch);
+    out_puts(&outline->out, " Y");
+    out_putFixed(&outline->out, (int32_t)(outline->size - y) * outline->pitch);
+}
+
+static bool outline_cb(void *ctx, uint8_t command, uint8_t x, uint8_t y) {
+    OutlineOutput *outline = (OutlineOutput *)ctx;
+    OutputBuffer *out = &outline->out;
+
+    switch (outline->format) {
+        case OUTLINE_SVG:
+            // After "z" the current point is the start of the outline, so moves stay relative
+            if (command == QRCODE_CONTOUR_MOVE) {
+                if (outline->first) {
+                    out_putc(out, 'M');
+                    svg_putPathInt(out, outline->ox + x, false);
+                    svg_putPathInt(out, outline->oy + y, true);
+                } else {
+                    out_putc(out, 'm');
+                    svg_putPathInt(out, x - outline->x, false);
+                    svg_putPathInt(out, y - outline->y, true);
+                }
+            } else if (command == QRCODE_CONTOUR_LINE) {
+                if (x != outline->x) {
+                    out_putc(out, 'h');
+                    out_putInt(out, x - outline->x);
+                } else {
+                    out_putc(out, 'v');
+                    out_putInt(out, y - outline->y);
+                }
+            } else {
+                out_putc(out, 'z');
+            }
+            break;
+
+        case OUTLINE_POLYLINE:
+            // Outlines are closed explicitly by repeating the first point
+            if (command != QRCODE_CONTOUR_MOVE) { out_putc(out, ' '); }
+            out_putInt(out, x);
+            out_putc(out, ',');
+            out_putInt(out, y);
+            if (command == QRCODE_CONTOUR_CLOSE) { out_putc(out, '\n'); }
+            break;
+
+        case OUTLINE_GCODE:
+            if (command == QRCODE_CONTOUR_MOVE) {
+                gcode_putPoint(outline, "G0", x, y);
+                out_puts(out, "\nM3\n");
+            } else {
+                gcode_putPoint(outline, "G1", x, y);
+                if (outline->first) {
+                    out_puts(out, " F");
+                    out_putInt(out, outline->feed);
+                    outline->first = false;
+                }
+                out_puts(out, command == QRCODE_CONTOUR_CLOSE ? "\nM5\n" : "\n");
+            }
+            break;
+    }
+
+    if (outline->format != OUTLINE_GCODE) { outline->first = false; }
+    outline->x = x;
+    outline->y = y;
+
+    return out->ok;
+}
+
+static int8_t outline_write(OutlineOutput *outline, QRCode *qrcode) {
+    outline->size = qrcode->size;
+    outline->first = true;
+    outline->x = outline->y = 0;
+    return qrcode_traceContours(qrcode, outline_cb, outline);
+}
+
+
+#pragma mark - PDF Output
+
+// Each page holds a grid of symbols; every symbol is a form XObject of rectangles in module
+// units, placed on the page by its content stream.  Streams are compressed with the PNG
+// encoder, which knows the compressed size after its counting pass, so /Length is written
+// directly.  Rather than keeping the offset of every object for the xref table, the body is
+// generated a second time into a sink that only counts bytes, noting where each object starts.
+
+typedef struct PDFOutput {
+    OutputBuffer out;
+    OutputBuffer *xref;         // Real output while replaying the body for the xref table
+    DeflateStream *stream;
+    QRCode *qrcodes;
+    uint16_t count;
+    uint16_t columns, rows;
+    int32_t cellWidth, cellHeight;  // Cell size in thousandths of a point
+    int32_t pageHeight;         // In thousandths of a point
+    int32_t module;             // Module size in thousandths of a point
+    uint8_t border;
+} PDFOutput;
+
+// Objects 1 and 2 are the catalog and page tree; each page is followed by its content
+// stream and the XObjects of its symbols.
+static uint32_t pdf_pageObject(PDFOutput *pdf, uint32_t page) {
+    return 3 + page * (2 + (uint32_t)pdf->columns * pdf->rows);
+}
+
+static bool pdf_compressText(void *ctx, const uint8_t *data, size_t length) {
+    deflate_write((DeflateStream *)ctx, data, length);
+    return true;
+}
+
+static bool pdf_writeCompressed(void *ctx, const uint8_t *data, size_t length) {
+    OutputBuffer *out = (OutputBuffer *)ctx;
+    out_write(out, data, length);
+    return out->ok;
+}
+
+static void pdf_beginObject(PDFOutput *pdf, uint32_t number) {
+    if (pdf->xref) {
+        // Each xref entry is exactly 20 bytes: 10 digit offset, generation, "n"
+        uint32_t offset = pdf->out.offset + (uint32_t)pdf->out.length;
+        char entry[21];
+        for (int8_t i = 9; i >= 0; i--, offset /= 10) { entry[i] = (char)('0' + offset % 10); }
+        memcpy(entry + 10, " 00000 n \n", 11);
+        out_puts(pdf->xref, entry);
+    }
+
+    out_putInt(&pdf->out, (int32_t)number);
+    out_puts(&pdf->out, " 0 obj\n");
+}
+
+// Writes the content of a page (qrcode == NULL) or of one symbol XObject.
+static void pdf_putContent(PDFOutput *pdf, OutputBuffer *out, uint32_t page, QRCode *qrcode) {
+    if (qrcode) {
+        // Flip the Y axis so rectangles are in module rows from the top...
+        QRCodeRectCursor cursor;
+        QRCodeRect rect;
+
+        out_puts(out, "1 0 0 -1 0 ");
+        out_putInt(out, qrcode->size);
+        out_puts(out, " cm\n");
+        qrcode_rectsBegin(qrcode, &cursor, QRCODE_COVER_ALL);
+        while (qrcode_nextRect(qrcode, &cursor, &rect)) {
+            out_putInt(out, rect.x);
+            out_putc(out, ' ');
+            out_putInt(out, rect.y);
+            out_putc(out, ' ');
+            out_putInt(out, rect.width);
+            out_putc(out, ' ');
+            out_putInt(out, rect.height);
+            out_puts(out, " re\n");
+        }
+        out_puts(out, "f\n");
+        return;
+    }
+
+    // Center each symbol in its cell...
+    uint32_t perPage = (uint32_t)pdf->columns * pdf->rows, first = page * perPage;
+    for (uint32_t i = first; i < pdf->count && i < first + perPage; i++) {
+        QRCode *symbol = pdf->qrcodes + i;
+        uint16_t column = (i - first) % pdf->columns, row = (i - first) / pdf->columns;
+        int32_t width = pdf->module * (symbol->size + 2 * pdf->border);
+        int32_t x = column * pdf->cellWidth + (pdf->cellWidth - width) / 2 + pdf->module * pdf->border;
+        int32_t y = pdf->pageHeight - (row + 1) * pdf->cellHeight + (pdf->cellHeight - width) / 2 + pdf->module * pdf->border;
+
+        out_puts(out, "q ");
+        out_putFixed(out, pdf->module);
+        out_puts(out, " 0 0 ");
+        out_putFixed(out, pdf->module);
+        out_putc(out, ' ');
+        out_putFixed(out, x);
+        out_putc(out, ' ');
+        out_putFixed(out, y);
+        out_puts(out, " cm /Q");
+        out_putInt(out, (int32_t)(i - first));
+        out_puts(out, " Do Q\n");
+    }
+}
+
+// Writes the rest of a stream object after its dictionary entries: the content is generated
+// once to count symbols and again to compress it, or only once while replaying.
+static void pdf_writeStream(PDFOutput *pdf, uint32_t page, QRCode *qrcode) {
+    OutputBuffer text;
+
+    deflate_begin(pdf->stream, pdf_writeCompressed, &pdf->out);
+    out_begin(&text, pdf_compressText, pdf->stream);
+    pdf_putContent(pdf, &text, page, qrcode);
+    out_finish(&text);
+
+    uint32_t length = deflate_buildTrees(pdf->stream);
+
+    out_puts(&pdf->out, "/Filter /FlateDecode /Length ");
+    out_putInt(&pdf->out, (int32_t)length);
+    out_puts(&pdf->out, " >>\nstream\n");
+
+    if (pdf->xref) {
+        pdf->out.offset += length;
+    } else {
+        deflate_putHeader(pdf->stream);
+        out_begin(&text, pdf_compressText, pdf->stream);
+        pdf_putContent(pdf, &text, page, qrcode);
+        out_finish(&text);
+        if (!deflate_finish(pdf->stream)) { pdf->out.ok = false; }
+    }
+
+    out_puts(&pdf->out, "\nendstream\nendobj\n");
+}
+
+// Writes the objects of one page.
+static void pdf_writePage(PDFOutput *pdf, uint32_t page, int32_t pageWidth) {
+    uint32_t number = pdf_pageObject(pdf, page);
+    uint32_t first = page * pdf->columns * pdf->rows;
+    uint32_t count = pdf->count - first;
+    if (count > (uint32_t)pdf->columns * pdf->rows) { count = (uint32_t)pdf->columns * pdf->rows; }
+
+    pdf_beginObject(pdf, number);
+    out_puts(&pdf->out, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 ");
+    out_putFixed(&pdf->out, pageWidth);
+    out_putc(&pdf->out, ' ');
+    out_putFixed(&pdf->out, pdf->pageHeight);
+    out_puts(&pdf->out, "] /Contents ");
+    out_putInt(&pdf->out, (int32_t)number + 1);
+    out_puts(&pdf->out, " 0 R /Resources << /XObject <<");
+    for (uint32_t i = 0; i < count; i++) {
+        out_puts(&pdf->out, " /Q");
+        out_putInt(&pdf->out, (int32_t)i);
+        out_putc(&pdf->out, ' ');
+        out_putInt(&pdf->out, (int32_t)(number + 2 + i));
+        out_puts(&pdf->out, " 0 R");
+    }
+    out_puts(&pdf->out, " >> >> >>\nendobj\n");
+
+    pdf_beginObject(pdf, number + 1);
+    out_puts(&pdf->out, "<< ");
+    pdf_writeStream(pdf, page, NULL);
+
+    for (uint32_t i = 0; i < count; i++) {
+        QRCode *qrcode = pdf->qrcodes + first + i;
+
+        pdf_beginObject(pdf, number + 2 + i);
+        out_puts(&pdf->out, "<< /Type /XObject /Subtype /Form /BBox [0 0 ");
+        out_putInt(&pdf->out, qrcode->size);
+        out_putc(&pdf->out, ' ');
+        out_putInt(&pdf->out, qrcode->size);
+        out_puts(&pdf->out, "] ");
+        pdf_writeStream(pdf, page, qrcode);
+    }
+}
+
+// Writes everything between the header and the xref table.
+static void pdf_writeBody(PDFOutput *pdf, int32_t pageWidth) {
+    uint32_t pages = (pdf->count + (uint32_t)pdf->columns * pdf->rows - 1) / ((uint32_t)pdf->columns * pdf->rows);
+
+    pdf_beginObject(pdf, 1);
+    out_puts(&pdf->out, "<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+
+    pdf_beginObject(pdf, 2);
+    out_puts(&pdf->out, "<< /Type /Pages /Count ");
+    out_putInt(&pdf->out, (int32_t)pages);
+    out_puts(&pdf->out, " /Kids [");
+    for (uint32_t page = 0; page < pages; page++) {
+        out_putInt(&pdf->out, (int32_t)pdf_pageObject(pdf, page));
+        out_puts(&pdf->out, " 0 R ");
+    }
+    out_puts(&pdf->out, "] >>\nendobj\n");
+
+    for (uint32_t page = 0; page < pages && pdf->out.ok; page++) {
+        pdf_writePage(pdf, page, pageWidth);
+    }
+}
+
+
+#pragma mark - Text Encodings
+
+// Hex and base64 text for the packed modules, and base64 for whole images, so they can be
+// embedded in HTML or JSON.  Image bytes are encoded as the writer produces them, so a data
+// URI never needs the binary image in memory.
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+static const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+typedef struct Base64Output {
+    OutputBuffer out;
+    uint8_t pending[3];         // Bytes waiting for a complete group of 3
+    uint8_t count;
+} Base64Output;
+
+// Encodes whole groups of 3 bytes into 4 characters each.
+static void base64_encode(const uint8_t *data, size_t groups, char *result) {
+    while (groups-- > 0) {
+        uint32_t value = (uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | data[2];
+
+        result[0] = BASE64_DIGITS[value >> 18];
+        result[1] = BASE64_DIGITS[(value >> 12) & 63];
+        result[2] = BASE64_DIGITS[(value >> 6) & 63];
+        result[3] = BASE64_DIGITS[value & 63];
+        data += 3;
+        result += 4;
+    }
+}
+
+// Encodes the last 1 or 2 bytes with "=" padding.
+static void base64_encodeTail(const uint8_t *data, uint8_t count, char *result) {
+    uint32_t value = (uint32_t)data[0] << 16 | (count > 1 ? (uint32_t)data[1] << 8 : 0);
+
+    result[0] = BASE64_DIGITS[value >> 18];
+    result[1] = BASE64_DIGITS[(value >> 12) & 63];
+    result[2] = count > 1 ? BASE64_DIGITS[(value >> 6) & 63] : '=';
+    result[3] = '=';
+}
+
+// Write callback that base64 encodes into the output buffer, whole groups at a time.
+static bool base64_cb(void *ctx, const uint8_t *data, size_t length) {
+    Base64Output *b64 = (Base64Output *)ctx;
+    OutputBuffer *out = &b64->out;
+
+    while (length > 0 && b64->count > 0 && b64->count < 3) {
+        b64->pending[b64->count++] = *data++;
+        length--;
+    }
+    if (b64->count == 3) {
+        if (out->length + 4 > sizeof(out->buffer)) { out_flush(out); }
+        base64_encode(b64->pending, 1, out->buffer + out->length);
+        out->length += 4;
+        b64->count = 0;
+    }
+
+    while (length >= 3) {
+        size_t groups = length / 3, room = (sizeof(out->buffer) - out->length) / 4;
+
+        if (room == 0) {
+            out_flush(out);
+            continue;
+        }
+        if (groups > room) { groups = room; }
+
+        base64_encode(data, groups, out->buffer + out->length);
+        out->length += groups * 4;
+        data += groups * 3;
+        length -= groups * 3;
+    }
+
+    while (length > 0) {
+        b64->pending[b64->count++] = *data++;
+        length--;
+    }
+
+    return out->ok;
+}
+
+static bool base64_finish(Base64Output *b64) {
+    OutputBuffer *out = &b64->out;
+
+    if (b64->count > 0) {
+        if (out->length + 4 > sizeof(out->buffer)) { out_flush(out); }
+        base64_encodeTail(b64->pending, b64->count, out->buffer + out->length);
+        out->length += 4;
+        b64->count = 0;
+    }
+
+    return out_finish(out);
+}
+
+// Caller buffer for the string functions; the terminating nul is added by the caller.
+typedef struct StringOutput {
+    char *buffer;
+    uint32_t size;              // Size of buffer, leaving room for the nul
+    uint32_t length;
+} StringOutput;
+
+static bool string_cb(void *ctx, const uint8_t *data, size_t length) {
+    StringOutput *str = (StringOutput *)ctx;
+
+    if (length > str->size - str->length) { return false; }
+    memcpy(str->buffer + str->length, data, length);
+    str->length += (uint32_t)length;
+
+    return true;
+}
+
+// Counting callback for the length functions.
+static bool count_cb(void *ctx, const uint8_t *data, size_t length) {
+    (void)data;
+    *(uint32_t *)ctx += (uint32_t)length;
+    return true;
+}
+
+// Returns the number of bytes in the modules buffer.
+static uint16_t text_getModuleBytes(QRCode *qrcode) {
+    if (qrcode->stride) { return (uint16_t)(qrcode->size * qrcode->stride); }
+    return (uint16_t)(((uint32_t)qrcode->size * qrcode->size + 7) / 8);
+}
+
+// Returns module byte "i", with the unused bits at the end of packed modules cleared (the
+// padding of aligned rows is already clear).
+static uint8_t text_getModuleByte(QRCode *qrcode, uint16_t i) {
+    uint32_t bits = (uint32_t)qrcode->size * qrcode->size;
+    uint8_t byte = qrcode->modules[i];
+
+    if (!qrcode->stride && (uint32_t)(i + 1) * 8 > bits) { byte &= (uint8_t)(0xff00 >> (bits & 7)); }
+    return byte;
+}
+
+
+#pragma mark - Public output functions
+
+int8_t qrcode_writePNG(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    QRCodeEncoder encoder;
+    return qrcode_writePNGWithEncoder(qrcode, scale, border, cb, ctx, &encoder);
+}
+
+int8_t qrcode_writePNGWithEncoder(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx, QRCodeEncoder *encoder) {
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+    if (scale == 0 || !cb || !encoder) { return -1; }
+
+    uint32_t width = (uint32_t)scale * (qrcode->size + 2 * border);
+
+    // PNG file header and IHDR chunk...
+    uint8_t ihdr[13];
+    png_putUInt32(ihdr, width);
+    png_putUInt32(ihdr + 4, width);
+    ihdr[8]  = 1;  // Bit depth
+    ihdr[9]  = 0;  // Color type grayscale
+    ihdr[10] = 0;  // Compression method 0 (deflate)
+    ihdr[11] = 0;  // Filter method 0 (adaptive)
+    ihdr[12] = 0;  // Interlace method 0 (no interlace)
+
+    if (!(cb)(ctx, signature, sizeof(signature)) || !png_writeChunk(cb, ctx, "IHDR", ihdr, sizeof(ihdr))) {
+        return -1;
+    }
+
+    // Compress the image into IDAT chunks, one buffer at a time; the first pass
+    // only counts symbols for the Huffman codes...
+    PNGOutput output = { cb, ctx };
+
+    deflate_begin(encoder, png_writeIDAT, &output);
+    png_writeLines(qrcode, scale, border, encoder);
+    deflate_start(encoder);
+    png_writeLines(qrcode, scale, border, encoder);
+
+    // Add the IEND chunk...
+    if (!deflate_finish(encoder) || !png_writeChunk(cb, ctx, "IEND", NULL, 0)) { return -1; }
+
+    return 0;
+}
+
+int8_t qrcode_writeGrayPNG(QRCode *qrcode, uint16_t size, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    QRCodeEncoder encoder;
+    return qrcode_writeGrayPNGWithEncoder(qrcode, size, border, cb, ctx, &encoder);
+}
+
+int8_t qrcode_writeGrayPNGWithEncoder(QRCode *qrcode, uint16_t size, uint8_t border, QRCodeWriteCallback cb, void *ctx, QRCodeEncoder *encoder) {
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+    if (size == 0 || size > GRAY_MAX_SIZE || !cb || !encoder) { return -1; }
+
+    GrayRenderer gray;
+    gray_begin(&gray, qrcode, size, border);
+
+    uint16_t coverage[gray.modules];
+    uint8_t ihdr[13];
+    png_putUInt32(ihdr, size);
+    png_putUInt32(ihdr + 4, size);
+    ihdr[8]  = 8;  // Bit depth
+    ihdr[9]  = 0;  // Color type grayscale
+    ihdr[10] = 0;  // Compression method 0 (deflate)
+    ihdr[11] = 0;  // Filter method 0 (adaptive)
+    ihdr[12] = 0;  // Interlace method 0 (no interlace)
+
+    if (!(cb)(ctx, signature, sizeof(signature)) || !png_writeChunk(cb, ctx, "IHDR", ihdr, sizeof(ihdr))) {
+        return -1;
+    }
+
+    PNGOutput output = { cb, ctx };
+
+    deflate_begin(encoder, png_writeIDAT, &output);
+    png_writeGrayLines(&gray, coverage, encoder);
+    deflate_start(encoder);
+    png_writeGrayLines(&gray, coverage, encoder);
+
+    if (!deflate_finish(encoder) || !png_writeChunk(cb, ctx, "IEND", NULL, 0)) { return -1; }
+
+    return 0;
+}
+
+int8_t qrcode_writeSVG(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    return qrcode_writeSVGSheet(qrcode, 1, 1, scale, border, cb, ctx);
+}
+
+int8_t qrcode_writeSVGSheet(QRCode *qrcodes, uint16_t count, uint16_t columns, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (count == 0 || columns == 0 || scale == 0 || !cb) { return -1; }
+
+    // Every symbol gets a cell big enough for the largest one...
+    uint8_t maxSize = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (qrcodes[i].size > maxSize) { maxSize = qrcodes[i].size; }
+    }
+
+    OutputBuffer out;
+    int32_t cell = maxSize + 2 * border;
+    int32_t rows = (count + columns - 1) / columns;
+    int32_t width = cell * (count < columns ? count : columns), height = cell * rows;
+
+    out_begin(&out, cb, ctx);
+    svg_putHeader(&out, width, height, scale);
+    out_puts(&out, SVG_DEFS);
+
+    for (uint16_t i = 0; i < count; i++) {
+        svg_writeSymbol(&out, qrcodes + i, (i % columns) * cell + border, (i / columns) * cell + border);
+    }
+
+    out_puts(&out, "</svg>\n");
+
+    return out_finish(&out) ? 0 : -1;
+}
+
+void qrcode_rasterBegin(QRCodeRaster *raster, QRCode *qrcode, uint8_t scale, uint8_t border) {
+    raster->qrcode = qrcode;
+    raster->scale = scale;
+    raster->border = border;
+    raster->width = (uint32_t)scale * (qrcode->size + 2 * border);
+    raster->row = 0;
+}
+
+uint16_t qrcode_rasterNext(QRCodeRaster *raster, uint8_t *buffer, uint32_t stride, uint16_t lines) {
+    if (raster->scale == 0 || !buffer) { return 0; }
+
+    BitmapRenderer bitmap;
+    bitmap_begin(&bitmap, raster->qrcode, raster->scale, raster->border);
+
+    uint32_t rowBytes = bitmap_getRowBytes(&bitmap);
+    uint16_t count = 0;
+    if (stride < rowBytes) { return 0; }
+
+    // The first line of each module row in the band is rendered (quiet zone rows are just
+    // cleared) and the lines after it copy the one above...
+    for (uint8_t *line = buffer; count < lines && raster->row < raster->width; count++, raster->row++, line += stride) {
+        int16_t y = (int16_t)((int32_t)(raster->row / raster->scale) - raster->border);
+
+        if (count > 0 && raster->row % raster->scale != 0) {
+            memcpy(line, line - stride, rowBytes);
+        } else if (y < 0 || y >= raster->qrcode->size) {
+            memset(line, 0, rowBytes);
+        } else {
+            bitmap_renderBytes(&bitmap, y, 0, rowBytes, line);
+        }
+    }
+
+    return count;
+}
+
+uint32_t qrcode_getImageSize(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border) {
+    if (format > QRCODE_IMAGE_BMP || scale == 0) { return 0; }
+
+    uint32_t width = (uint32_t)scale * (qrcode->size + 2 * border);
+    uint64_t size = (uint64_t)raw_getRowBytes(format, width) * width;
+    if (size > 0xffffffffu - BMP_HEADER_SIZE) { return 0; }
+
+    return raw_putHeader(format, width, (uint32_t)size, NULL) + (uint32_t)size;
+}
+
+int8_t qrcode_renderRow(QRCode *qrcode, uint32_t row, uint8_t scale, uint8_t border, uint8_t *buffer) {
+    if (scale == 0 || !buffer || row >= (uint32_t)scale * (qrcode->size + 2 * border)) { return -1; }
+
+    BitmapRenderer bitmap;
+    bitmap_begin(&bitmap, qrcode, scale, border);
+    bitmap_renderBytes(&bitmap, (int16_t)((int32_t)(row / scale) - border), 0, bitmap_getRowBytes(&bitmap), buffer);
+
+    return 0;
+}
+
+int8_t qrcode_renderBitmap(QRCode *qrcode, uint8_t scale, uint8_t border, uint8_t *buffer, uint32_t stride) {
+    if (scale == 0 || !buffer) { return -1; }
+
+    BitmapRenderer bitmap;
+    bitmap_begin(&bitmap, qrcode, scale, border);
+
+    uint32_t rowBytes = bitmap_getRowBytes(&bitmap);
+    if (stride < rowBytes) { return -1; }
+
+    // Render each module row once, then copy it...
+    for (int16_t y = -(int16_t)border; y < qrcode->size + border; y++) {
+        uint8_t *first = buffer + (size_t)(y + border) * scale * stride;
+
+        bitmap_renderBytes(&bitmap, y, 0, rowBytes, first);
+        for (uint8_t copy = 1; copy < scale; copy++) { memcpy(first + (size_t)copy * stride, first, rowBytes); }
+    }
+
+    return 0;
+}
+
+int8_t qrcode_renderGray(QRCode *qrcode, uint16_t size, uint8_t border, uint8_t *buffer, uint32_t stride) {
+    if (size == 0 || !buffer || stride < size) { return -1; }
+
+    GrayRenderer gray;
+    gray_begin(&gray, qrcode, size, border);
+
+    uint16_t coverage[gray.modules];
+    int32_t previous = -1;
+
+    for (uint16_t row = 0; row < size; row++) {
+        uint8_t *line = buffer + (size_t)row * stride;
+        int32_t key = gray_getRowKey(&gray, row);
+
+        if (key >= 0 && key == previous) {
+            memcpy(line, line - stride, size);
+        } else {
+            gray_prepareRow(&gray, row, coverage);
+            gray_renderPixels(&gray, coverage, 0, size, line);
+        }
+        previous = key;
+    }
+
+    return 0;
+}
+
+int8_t qrcode_writePGM(QRCode *qrcode, uint16_t size, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (size == 0 || !cb) { return -1; }
+
+    GrayRenderer gray;
+    gray_begin(&gray, qrcode, size, border);
+
+    uint16_t coverage[gray.modules];
+    int32_t previous = -1;
+    OutputBuffer out;
+
+    out_begin(&out, cb, ctx);
+    out_puts(&out, "P5\n");
+    out_putInt(&out, size);
+    out_putc(&out, ' ');
+    out_putInt(&out, size);
+    out_puts(&out, "\n255\n");
+
+    // Each row is rendered straight into the output buffer, a piece at a time...
+    for (uint16_t row = 0; row < size; row++) {
+        int32_t key = gray_getRowKey(&gray, row);
+
+        if (key < 0 || key != previous) { gray_prepareRow(&gray, row, coverage); }
+        previous = key;
+
+        for (uint32_t x = 0; x < size;) {
+            uint32_t count = size - x;
+            if (count > sizeof(out.buffer) - out.length) { count = (uint32_t)(sizeof(out.buffer) - out.length); }
+
+            gray_renderPixels(&gray, coverage, x, count, (uint8_t *)out.buffer + out.length);
+            out.length += count;
+            x += count;
+
+            if (out.length == sizeof(out.buffer)) { out_flush(&out); }
+        }
+    }
+
+    return out_finish(&out) ? 0 : -1;
+}
+
+int8_t qrcode_renderPages(QRCode *qrcode, uint8_t scale, uint8_t border, int16_t x, int16_t y, uint8_t *buffer, uint16_t width, uint16_t height) {
+    if (scale == 0 || !buffer) { return -1; }
+
+    // Clip the symbol and its quiet zone to the display...
+    int32_t extent = (int32_t)scale * (qrcode->size + 2 * border);
+    int32_t x0 = x < 0 ? 0 : x, x1 = x + extent > width ? width : x + extent;
+    int32_t y0 = y < 0 ? 0 : y, y1 = y + extent > height ? height : y + extent;
+    if (x0 >= x1 || y0 >= y1) { return 0; }
+
+    uint8_t rows[8][(x1 + 7) / 8];
+
+    for (int32_t page = y0 / 8; page * 8 < y1; page++) {
+        uint8_t mask = 0;
+        int32_t previous = -1;
+
+        // Render the rows of this page that the symbol covers, copying repeated module rows...
+        for (uint8_t i = 0; i < 8; i++) {
+            int32_t py = page * 8 + i;
+
+            if (py < y0 || py >= y1) {
+                memset(rows[i], 0, sizeof(rows[i]));
+                continue;
+            }
+
+            int32_t row = py - y;
+            mask |= (uint8_t)(1 << i);
+
+            if (previous >= 0 && row / scale == previous / scale) {
+                memcpy(rows[i], rows[i - 1], sizeof(rows[i]));
+            } else {
+                page_renderRow(qrcode, row, x, scale, border, x0, x1, rows[i]);
+            }
+            previous = row;
+        }
+
+        // Then transpose 8 columns at a time into the page...
+        uint8_t *dest = buffer + (uint32_t)page * width;
+
+        for (int32_t group = x0 / 8; group * 8 < x1; group++) {
+            uint8_t block[8], columns[8];
+
+            for (uint8_t i = 0; i < 8; i++) { block[i] = rows[i][group]; }
+            page_transpose8(block, columns);
+
+            for (uint8_t i = 0; i < 8; i++) {
+                int32_t px = group * 8 + i;
+                if (px >= x0 && px < x1) { dest[px] = (uint8_t)((dest[px] & ~mask) | (columns[i] & mask)); }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int8_t qrcode_blit(QRCode *qrcode, void *buffer, uint32_t stride, uint16_t width, uint16_t height, uint8_t format, int16_t x, int16_t y, uint8_t scale, uint32_t fg, uint32_t bg) {
+    if (scale == 0 || !buffer || format > QRCODE_PIXEL_ARGB8888) { return -1; }
+
+    // Clip the symbol to the frame buffer...
+    int32_t extent = (int32_t)scale * qrcode->size;
+    int32_t x0 = x < 0 ? 0 : x, x1 = x + extent > width ? width : x + extent;
+    int32_t y0 = y < 0 ? 0 : y, y1 = y + extent > height ? height : y + extent;
+    if (x0 >= x1 || y0 >= y1) { return 0; }
+
+    uint8_t *pixels = (uint8_t *)buffer, bpp = format == QRCODE_PIXEL_RGB565 ? 2 : 4;
+    size_t offset = (size_t)x0 * bpp, length = (size_t)(x1 - x0) * bpp;
+
+    uint8_t table[16][4 * BLIT_TABLE_SCALE];
+    if (scale * bpp <= BLIT_TABLE_SCALE) { blit_buildTable(table, format, scale, fg, bg); }
+
+    // Render the first visible line of each module row, then copy it down...
+    for (int32_t py = y0; py < y1;) {
+        uint8_t my = (uint8_t)((py - y) / scale);
+        int32_t end = y + ((int32_t)my + 1) * scale;
+        uint8_t *first = pixels + (size_t)py * stride;
+
+        if (end > y1) { end = y1; }
+
+        blit_renderLine(qrcode, my, x, scale, x0, x1, format, fg, bg, table, first);
+        for (py++; py < end; py++) { memcpy(pixels + (size_t)py * stride + offset, first + offset, length); }
+    }
+
+    return 0;
+}
+
+int8_t qrcode_renderImage(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, uint8_t *buffer, uint32_t size) {
+    uint32_t needed = qrcode_getImageSize(qrcode, format, scale, border);
+    if (needed == 0 || !buffer || size < needed) { return -1; }
+
+    uint32_t width = (uint32_t)scale * (qrcode->size + 2 * border);
+    uint32_t rowBytes = raw_getRowBytes(format, width);
+    uint8_t *image = buffer + raw_putHeader(format, width, rowBytes * width, buffer);
+    BitmapRenderer bitmap;
+
+    bitmap_begin(&bitmap, qrcode, scale, border);
+
+    // Render each module row (and the quiet zone) once, then copy it; BMP rows are stored
+    // bottom-up...
+    for (int16_t y = -(int16_t)border; y < qrcode->size + border; y++) {
+        uint32_t row = (uint32_t)(y + border) * scale;
+        uint8_t *first = image + (format == QRCODE_IMAGE_BMP ? width - 1 - row : row) * rowBytes;
+
+        raw_renderRow(&bitmap, format, y, width, rowBytes, first);
+        for (uint8_t copy = 1; copy < scale; copy++) {
+            uint8_t *dest = format == QRCODE_IMAGE_BMP ? first - copy * rowBytes : first + copy * rowBytes;
+            memcpy(dest, first, rowBytes);
+        }
+    }
+
+    return 0;
+}
+
+int8_t qrcode_writeTIFF(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (scale == 0 || !cb) { return -1; }
+
+    G4Output g4;
+    uint32_t width = (uint32_t)scale * (qrcode->size + 2 * border);
+
+    // Measure the compressed image first, so the header can come before it...
+    out_begin(&g4.out, out_discard, NULL);
+    uint32_t length = g4_writeImage(&g4, qrcode, scale, border, width);
+
+    // Little-endian header, then one IFD with 13 entries, the resolution and the strip
+    const uint16_t entries = 13;
+    uint32_t resolution = 8 + 2 + entries * 12 + 4, strip = resolution + 16;
+
+    out_begin(&g4.out, cb, ctx);
+    out_puts(&g4.out, "II*");
+    out_putc(&g4.out, 0);
+    tiff_putLong(&g4.out, 8);
+
+    tiff_putShort(&g4.out, entries);
+    tiff_putEntry(&g4.out, 256, 4, width);          // ImageWidth
+    tiff_putEntry(&g4.out, 257, 4, width);          // ImageLength
+    tiff_putEntry(&g4.out, 258, 3, 1);              // BitsPerSample
+    tiff_putEntry(&g4.out, 259, 3, 4);              // Compression = CCITT T.6
+    tiff_putEntry(&g4.out, 262, 3, 0);              // PhotometricInterpretation = WhiteIsZero
+    tiff_putEntry(&g4.out, 273, 4, strip);          // StripOffsets
+    tiff_putEntry(&g4.out, 277, 3, 1);              // SamplesPerPixel
+    tiff_putEntry(&g4.out, 278, 4, width);          // RowsPerStrip
+    tiff_putEntry(&g4.out, 279, 4, length);         // StripByteCounts
+    tiff_putEntry(&g4.out, 282, 5, resolution);     // XResolution
+    tiff_putEntry(&g4.out, 283, 5, resolution + 8); // YResolution
+    tiff_putEntry(&g4.out, 293, 4, 0);              // T6Options
+    tiff_putEntry(&g4.out, 296, 3, 2);              // ResolutionUnit = inch
+    tiff_putLong(&g4.out, 0);                       // No more IFDs
+
+    tiff_putLong(&g4.out, TIFF_DPI);
+    tiff_putLong(&g4.out, 1);
+    tiff_putLong(&g4.out, TIFF_DPI);
+    tiff_putLong(&g4.out, 1);
+
+    g4_writeImage(&g4, qrcode, scale, border, width);
+
+    return out_finish(&g4.out) ? 0 : -1;
+}
+
+int8_t qrcode_writeESCPOS(QRCode *qrcode, uint8_t mode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (mode > QRCODE_ESCPOS_COLUMN || scale == 0 || !cb) { return -1; }
+
+    uint32_t width = (uint32_t)scale * (qrcode->size + 2 * border);
+    if (width > ESCPOS_MAX_DOTS) { return -1; }
+
+    OutputBuffer out;
+    out_begin(&out, cb, ctx);
+
+    if (mode == QRCODE_ESCPOS_RASTER) {
+        escpos_writeRaster(&out, qrcode, scale, border, width);
+    } else {
+        escpos_writeColumns(&out, qrcode, scale, border, width);
+    }
+
+    return out_finish(&out) ? 0 : -1;
+}
+
+int8_t qrcode_writeZPL(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (scale == 0 || !cb) { return -1; }
+
+    uint32_t width = (uint32_t)scale * (qrcode->size + 2 * border);
+    uint32_t rowBytes = (width + 7) / 8;
+
+    ZPLOutput zpl;
+    out_begin(&zpl.out, cb, ctx);
+    bitmap_begin(&zpl.bitmap, qrcode, scale, border);
+    zpl.digit = 0;
+    zpl.repeat = 0;
+
+    // "^GFA,total bytes,field bytes,bytes per row,data"
+    out_puts(&zpl.out, "^XA\n^FO0,0^GFA,");
+    out_putInt(&zpl.out, (int32_t)(rowBytes * width));
+    out_putc(&zpl.out, ',');
+    out_putInt(&zpl.out, (int32_t)(rowBytes * width));
+    out_putc(&zpl.out, ',');
+    out_putInt(&zpl.out, (int32_t)rowBytes);
+    out_putc(&zpl.out, ',');
+
+    for (int16_t y = -(int16_t)border; y < qrcode->size + border; y++) {
+        bool inside = y >= 0 && y < qrcode->size;
+
+        // The first pixel row of a module row is only written if it differs from the row above...
+        if (inside && (y == 0 || !zpl_rowsEqual(qrcode, (uint8_t)(y - 1), (uint8_t)y))) {
+            zpl_putRow(&zpl, (uint8_t)y);
+        } else if (y == -(int16_t)border || y == qrcode->size) {
+            out_putc(&zpl.out, ',');
+        } else {
+            out_putc(&zpl.out, ':');
+        }
+
+        for (uint8_t copy = 1; copy < scale; copy++) { out_putc(&zpl.out, ':'); }
+        out_putc(&zpl.out, '\n');
+    }
+
+    out_puts(&zpl.out, "^FS\n^XZ\n");
+
+    return out_finish(&zpl.out) ? 0 : -1;
+}
+
+int8_t qrcode_writeText(QRCode *qrcode, uint8_t options, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (!cb) { return -1; }
+
+    OutputBuffer out;
+    out_begin(&out, cb, ctx);
+
+    bool invert = (options & QRCODE_TEXT_INVERT) != 0;
+    int16_t size = qrcode->size;
+    uint8_t cells[size + 2 * border];
+
+    for (int16_t y = -(int16_t)border; y < size + border; y += 2) {
+        // Black on bright white, or bright white on black when drawing light modules...
+        if (options & QRCODE_TEXT_ANSI) { out_puts(&out, invert ? "\033[97;40m" : "\033[30;107m"); }
+
+        // Mark the dark modules of both rows; inverted, the light ones are drawn instead,
+        // except in the space below an odd number of rows...
+        uint8_t rows = y + 1 < size + border ? 3 : 2;
+
+        memset(cells, 0, sizeof(cells));
+        text_markRow(qrcode, y, border, 2, cells);
+        text_markRow(qrcode, y + 1, border, 1, cells);
+
+        for (uint16_t x = 0; x < sizeof(cells); x++) {
+            out_puts(&out, TEXT_BLOCKS[invert ? ~cells[x] & rows : cells[x]]);
+        }
+
+        if (options & QRCODE_TEXT_ANSI) { out_puts(&out, "\033[0m"); }
+        out_putc(&out, '\n');
+    }
+
+    return out_finish(&out) ? 0 : -1;
+}
+
+int8_t qrcode_writeEPS(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (scale == 0 || !cb) { return -1; }
+
+    OutputBuffer out;
+    int32_t width = qrcode->size + 2 * border;
+
+    out_begin(&out, cb, ctx);
+    out_puts(&out, "%!PS-Adobe-3.0 EPSF-3.0\n%%BoundingBox: 0 0 ");
+    out_putInt(&out, width * scale);
+    out_putc(&out, ' ');
+    out_putInt(&out, width * scale);
+    out_puts(&out, "\n%%Creator: QRCode\n%%LanguageLevel: 2\n%%EndComments\n");
+    out_puts(&out, EPS_PROLOG);
+
+    // White background, then flip to module rows from the top of the symbol...
+    out_puts(&out, "gsave\n");
+    out_putInt(&out, scale);
+    out_putc(&out, ' ');
+    out_putInt(&out, scale);
+    out_puts(&out, " scale\n1 setgray 0 0 ");
+    out_putInt(&out, width);
+    out_putc(&out, ' ');
+    out_putInt(&out, width);
+    out_puts(&out, " rectfill\n0 setgray\n");
+    out_putInt(&out, border);
+    out_putc(&out, ' ');
+    out_putInt(&out, border + qrcode->size);
+    out_puts(&out, " translate 1 -1 scale\n");
+
+    eps_writeSymbol(&out, qrcode);
+
+    out_puts(&out, "grestore\nshowpage\n%%EOF\n");
+
+    return out_finish(&out) ? 0 : -1;
+}
+
+int8_t qrcode_writeSVGOutline(QRCode *qrcode, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (scale == 0 || !cb) { return -1; }
+
+    OutlineOutput outline;
+    int32_t width = qrcode->size + 2 * border;
+
+    outline.format = OUTLINE_SVG;
+    outline.ox = outline.oy = border;
+
+    out_begin(&outline.out, cb, ctx);
+    svg_putHeader(&outline.out, width, width, scale);
+    out_puts(&outline.out, "<path d=\"");
+    if (outline_write(&outline, qrcode) < 0) { return -1; }
+    out_puts(&outline.out, "\"/>\n</svg>\n");
+
+    return out_finish(&outline.out) ? 0 : -1;
+}
+
+int8_t qrcode_writePolylines(QRCode *qrcode, QRCodeWriteCallback cb, void *ctx) {
+    if (!cb) { return -1; }
+
+    OutlineOutput outline;
+    outline.format = OUTLINE_POLYLINE;
+
+    out_begin(&outline.out, cb, ctx);
+    if (outline_write(&outline, qrcode) < 0) { return -1; }
+
+    return out_finish(&outline.out) ? 0 : -1;
+}
+
+int8_t qrcode_writeGCode(QRCode *qrcode, uint16_t pitch, uint16_t feed, QRCodeWriteCallback cb, void *ctx) {
+    if (pitch == 0 || feed == 0 || !cb) { return -1; }
+
+    OutlineOutput outline;
+    outline.format = OUTLINE_GCODE;
+    outline.pitch = pitch;
+    outline.feed = feed;
+
+    // Millimetres, absolute positions, laser off...
+    out_begin(&outline.out, cb, ctx);
+    out_puts(&outline.out, "G21\nG90\nM5\n");
+    if (outline_write(&outline, qrcode) < 0) { return -1; }
+    out_puts(&outline.out, "G0 X0.000 Y0.000\nM2\n");
+
+    return out_finish(&outline.out) ? 0 : -1;
+}
+
+int8_t qrcode_writePDF(QRCode *qrcodes, uint16_t count, uint16_t columns, uint16_t rows, uint16_t pageWidth, uint16_t pageHeight, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    QRCodeEncoder encoder;
+    return qrcode_writePDFWithEncoder(qrcodes, count, columns, rows, pageWidth, pageHeight, border, cb, ctx, &encoder);
+}
+
+int8_t qrcode_writePDFWithEncoder(QRCode *qrcodes, uint16_t count, uint16_t columns, uint16_t rows, uint16_t pageWidth, uint16_t pageHeight, uint8_t border, QRCodeWriteCallback cb, void *ctx, QRCodeEncoder *encoder) {
+    if (count == 0 || columns == 0 || rows == 0 || pageWidth == 0 || pageHeight == 0 || !cb || !encoder) { return -1; }
+
+    // Every symbol gets the same module size, fitting the largest one in a cell...
+    uint8_t maxSize = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (qrcodes[i].size > maxSize) { maxSize = qrcodes[i].size; }
+    }
+
+    PDFOutput pdf;
+
+    pdf.xref = NULL;
+    pdf.stream = encoder;
+    pdf.qrcodes = qrcodes;
+    pdf.count = count;
+    pdf.columns = columns;
+    pdf.rows = rows;
+    pdf.cellWidth = pageWidth * 1000 / columns;
+    pdf.cellHeight = pageHeight * 1000 / rows;
+    pdf.pageHeight = pageHeight * 1000;
+    pdf.module = (pdf.cellWidth < pdf.cellHeight ? pdf.cellWidth : pdf.cellHeight) / (maxSize + 2 * border);
+    pdf.border = border;
+
+    // Header with a binary comment, then the objects...
+    out_begin(&pdf.out, cb, ctx);
+    out_puts(&pdf.out, "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n");
+    pdf_writeBody(&pdf, pageWidth * 1000);
+
+    // Replay the body into a counting sink to list the object offsets...
+    uint32_t pages = (count + (uint32_t)columns * rows - 1) / ((uint32_t)columns * rows);
+    uint32_t objects = 3 + 2 * pages + count;
+    uint32_t xrefOffset = pdf.out.offset + (uint32_t)pdf.out.length;
+    OutputBuffer *out = &pdf.out;
+    PDFOutput replay = pdf;
+
+    out_puts(out, "xref\n0 ");
+    out_putInt(out, (int32_t)objects);
+    out_puts(out, "\n0000000000 65535 f \n");
+
+    replay.xref = out;
+    out_begin(&replay.out, out_discard, NULL);
+    out_puts(&replay.out, "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n");
+    pdf_writeBody(&replay, pageWidth * 1000);
+
+    out_puts(out, "trailer\n<< /Size ");
+    out_putInt(out, (int32_t)objects);
+    out_puts(out, " /Root 1 0 R >>\nstartxref\n");
+    out_putInt(out, (int32_t)xrefOffset);
+    out_puts(out, "\n%%EOF\n");
+
+    return out_finish(out) ? 0 : -1;
+}
+
+uint16_t qrcode_getHexLength(QRCode *qrcode) {
+    return (uint16_t)(text_getModuleBytes(qrcode) * 2 + 1);
+}
+
+void qrcode_getHex(QRCode *qrcode, char *result) {
+    uint16_t bytes = text_getModuleBytes(qrcode);
+
+    for (uint16_t i = 0; i < bytes; i++) {
+        uint8_t byte = text_getModuleByte(qrcode, i);
+        *result++ = HEX_DIGITS[byte >> 4];
+        *result++ = HEX_DIGITS[byte & 15];
+    }
+    *result = '\0';
+}
+
+uint16_t qrcode_getBase64Length(QRCode *qrcode) {
+    return (uint16_t)((text_getModuleBytes(qrcode) + 2) / 3 * 4 + 1);
+}
+
+void qrcode_getBase64(QRCode *qrcode, char *result) {
+    uint16_t bytes = text_getModuleBytes(qrcode);
+
+    // Whole groups straight from the modules, leaving the masked last byte for the tail...
+    uint16_t groups = (uint16_t)((bytes - 1) / 3);
+    base64_encode(qrcode->modules, groups, result);
+    result += groups * 4;
+
+    uint8_t tail[3];
+    uint8_t count = (uint8_t)(bytes - groups * 3);
+    for (uint8_t i = 0; i < count; i++) { tail[i] = text_getModuleByte(qrcode, (uint16_t)(groups * 3 + i)); }
+
+    if (count == 3) {
+        base64_encode(tail, 1, result);
+    } else {
+        base64_encodeTail(tail, count, result);
+    }
+    result[4] = '\0';
+}
+
+int8_t qrcode_writeDataURI(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, QRCodeWriteCallback cb, void *ctx) {
+    if (format > QRCODE_URI_SVG || !cb) { return -1; }
+
+    // The image is encoded as the writer produces it...
+    Base64Output b64;
+    int8_t result;
+
+    out_begin(&b64.out, cb, ctx);
+    out_puts(&b64.out, format == QRCODE_URI_PNG ? "data:image/png;base64," : "data:image/svg+xml;base64,");
+    b64.count = 0;
+
+    if (format == QRCODE_URI_PNG) {
+        result = qrcode_writePNG(qrcode, scale, border, base64_cb, &b64);
+    } else {
+        result = qrcode_writeSVG(qrcode, scale, border, base64_cb, &b64);
+    }
+
+    return base64_finish(&b64) && result == 0 ? 0 : -1;
+}
+
+uint32_t qrcode_getDataURILength(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border) {
+    uint32_t length = 0;
+
+    if (qrcode_writeDataURI(qrcode, format, scale, border, count_cb, &length) != 0) { return 0; }
+
+    return length + 1;
+}
+
+int8_t qrcode_getDataURI(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, char *buffer, uint32_t size) {
+    if (!buffer || size == 0) { return -1; }
+
+    StringOutput str = { buffer, size - 1, 0 };
+
+    if (qrcode_writeDataURI(qrcode, format, scale, border, string_cb, &str) != 0) { return -1; }
+    buffer[str.length] = '\0';
+
+    return 0;
+}
@@ -1,9 +1,16 @@
 /**
- * Test program that generates a SVG QR code using the API.
+ * Test program that generates a QR code image, outline or G-code program using the API.
  *
  * Usage:
  *
- *   ./testqrcode [-e {low,medium,quartile,high}] [-v VERSION] TEXT >FILENAME.svg
+ *   ./testqrcode [-b BORDER] [-c COLUMNS] [-e {low,medium,quartile,high}]
+ *                [-f {png,tiff,pbm,pgm,bmp,svg,eps,outline,polyline,gcode,pdf,
+ *                     escpos,escpos-column,zpl,text,text-invert,ansi,gray-png,
+ *                     gray-pgm,hex,base64,png-uri,svg-uri}]
+ *                [-p PITCH] [-r ROWS] [-s SCALE]
+ *                [-t {rotate-90,rotate-180,rotate-270,transpose,mirror,flip,invert}]
+ *                [-v VERSION] [-w WIDTH]
+ *                TEXT >FILENAME.{png,tiff,pbm,pgm,bmp,svg,eps,txt,gcode,pdf,prn,zpl}
  *
  * The MIT License (MIT)
  *
@@ -33,21 +40,64 @@
  * THE SOFTWARE.
  */
 
+#define _DEFAULT_SOURCE                 // fileno, ftruncate and MAP_ANONYMOUS with -std=c99
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "qrcode.h"
-#include <zlib.h>
+
+#ifndef MAP_ANONYMOUS
+#  define MAP_ANONYMOUS MAP_ANON
+#endif
 
 
-// Image export constants...
+// Image export defaults...
 #define QR_SCALE    5                  // Nominal size of modules
 #define QR_PADDING  4                  // White padding around QR code
-
-
-// Local function for PNG output...
-static unsigned char *png_add_crc(unsigned char *pngdata, unsigned char *pngptr, unsigned char *pngend);
-static unsigned char *png_add_unsigned(unsigned val, unsigned char *pngptr, unsigned char *pngend);
+#define QR_PITCH    250                // G-code module pitch in micrometres
+#define QR_FEED     1000               // G-code feed rate in mm/min
+#define QR_COLUMNS  3                  // PDF labels across a page
+#define QR_ROWS     10                 // PDF labels down a page
+#define QR_PAGE_W   612                // PDF page width in points (US Letter)
+#define QR_PAGE_H   792                // PDF page height in points
+
+
+// Output formats...
+enum {
+    FORMAT_PNG,                         // PNG image
+    FORMAT_SVG,                         // SVG image
+    FORMAT_OUTLINE,                     // SVG outlines
+    FORMAT_POLYLINE,                    // Polyline text
+    FORMAT_GCODE,                       // G-code for laser marking
+    FORMAT_PDF,                         // PDF label sheets
+    FORMAT_EPS,                         // Encapsulated PostScript
+    FORMAT_TIFF,                        // TIFF image with Group 4 compression
+    FORMAT_PBM,                         // Uncompressed PBM image
+    FORMAT_PGM,                         // Uncompressed PGM image
+    FORMAT_BMP,                         // Uncompressed BMP image
+    FORMAT_ESCPOS,                      // ESC/POS raster bit image
+    FORMAT_ESCPOS_COLUMN,               // ESC/POS 24 dot column bit image
+    FORMAT_ZPL,                         // ZPL label with a compressed graphic field
+    FORMAT_TEXT,                        // Half block text
+    FORMAT_TEXT_INVERT,                 // Half block text for dark terminals
+    FORMAT_ANSI,                        // Half block text with ANSI colors
+    FORMAT_HEX,                         // Packed modules as hex
+    FORMAT_BASE64,                      // Packed modules as base64
+    FORMAT_PNG_URI,                     // PNG data URI
+    FORMAT_SVG_URI,                     // SVG data URI
+    FORMAT_GRAY_PNG,                    // Anti-aliased PNG image
+    FORMAT_GRAY_PGM                     // Anti-aliased PGM image
+};
+
+
+// Local functions...
+static QRCode *read_codes(FILE *fp, uint8_t version, uint8_t ecc, uint16_t *count);
+static bool render_image(QRCode *qrcode, uint8_t format, uint8_t scale, uint8_t border, FILE *fp);
+static bool write_cb(void *ctx, const uint8_t *data, size_t length);
 
 
 // Main entry
@@ -60,7 +110,14 @@ int main(int argc, char *argv[]) {
     QRCode     qrcode;                  // QR code data
     uint8_t    qrcodeBytes[qrcode_getBufferSize(VERSION_MAX)];
                                         // QR code buffer
-    bool       makeSVG = false;         // Output SVG?
+    int        format = FORMAT_PNG;     // Output format
+    uint8_t    scale = QR_SCALE;        // Size of modules
+    uint8_t    border = QR_PADDING;     // Quiet zone around QR code
+    uint16_t   pitch = QR_PITCH;        // Module pitch in micrometres
+    uint16_t   columns = QR_COLUMNS;    // Labels across a page
+    uint16_t   rows = QR_ROWS;          // Labels down a page
+    uint16_t   width = 0;               // Anti-aliased image width, 0 for scale * modules
+    uint8_t    transform = 0;           // QRCODE_xxx transforms
 
 
     // Parse command-line...
@@ -70,9 +127,39 @@ int main(int argc, char *argv[]) {
       progname = argv[0];
 
     for (i = 1; i < argc; i ++) {
-        if (argv[i][0] == '-') {
+        if (argv[i][0] == '-' && argv[i][1]) {
             for (const char *opt = argv[i] + 1; *opt; opt ++) {
                 switch (*opt) {
+                    case 'b' : /* -b BORDER */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing border after '-b'.\n", progname);
+                            return 1;
+                        } else {
+                            long tempval = strtol(argv[i], NULL, 10);
+                            if (tempval < 0 || tempval > 255) {
+                                fprintf(stderr, "%s: Bad border '-b %s'.\n", progname, argv[i]);
+                                return 1;
+                            }
+                            border = (uint8_t)tempval;
+                        }
+                        break;
+
+                    case 'c' : /* -c COLUMNS */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing columns after '-c'.\n", progname);
+                            return 1;
+                        } else {
+                            long tempval = strtol(argv[i], NULL, 10);
+                            if (tempval < 1 || tempval > 100) {
+                                fprintf(stderr, "%s: Bad columns '-c %s'.\n", progname, argv[i]);
+                                return 1;
+                            }
+                            columns = (uint16_t)tempval;
+                        }
+                        break;
+
                     case 'e' : /* -e ECC */
                         i ++;
                         if (i >= argc) {
@@ -98,15 +185,144 @@ int main(int argc, char *argv[]) {
                             fprintf(stderr, "%s: Missing format after '-f'.\n", progname);
                             return 1;
                         } else {
-                            if (!strcmp(argv[i], "svg")) {
-                                makeSVG = true;
-                            } else if (strcmp(argv[i], "png")) {
+                            if (!strcmp(argv[i], "png")) {
+                                format = FORMAT_PNG;
+                            } else if (!strcmp(argv[i], "svg")) {
+                                format = FORMAT_SVG;
+                            } else if (!strcmp(argv[i], "outline")) {
+                                format = FORMAT_OUTLINE;
+                            } else if (!strcmp(argv[i], "polyline")) {
+                                format = FORMAT_POLYLINE;
+                            } else if (!strcmp(argv[i], "gcode")) {
+                                format = FORMAT_GCODE;
+                            } else if (!strcmp(argv[i], "pdf")) {
+                                format = FORMAT_PDF;
+                            } else if (!strcmp(argv[i], "eps")) {
+                                format = FORMAT_EPS;
+                            } else if (!strcmp(argv[i], "tiff")) {
+                                format = FORMAT_TIFF;
+                            } else if (!strcmp(argv[i], "pbm")) {
+                                format = FORMAT_PBM;
+                            } else if (!strcmp(argv[i], "pgm")) {
+                                format = FORMAT_PGM;
+                            } else if (!strcmp(argv[i], "bmp")) {
+                                format = FORMAT_BMP;
+                            } else if (!strcmp(argv[i], "escpos")) {
+                                format = FORMAT_ESCPOS;
+                            } else if (!strcmp(argv[i], "escpos-column")) {
+                                format = FORMAT_ESCPOS_COLUMN;
+                            } else if (!strcmp(argv[i], "zpl")) {
+                                format = FORMAT_ZPL;
+                            } else if (!strcmp(argv[i], "text")) {
+                                format = FORMAT_TEXT;
+                            } else if (!strcmp(argv[i], "text-invert")) {
+                                format = FORMAT_TEXT_INVERT;
+                            } else if (!strcmp(argv[i], "ansi")) {
+                                format = FORMAT_ANSI;
+                            } else if (!strcmp(argv[i], "gray-png")) {
+                                format = FORMAT_GRAY_PNG;
+                            } else if (!strcmp(argv[i], "gray-pgm")) {
+                                format = FORMAT_GRAY_PGM;
+                            } else if (!strcmp(argv[i], "hex")) {
+                                format = FORMAT_HEX;
+                            } else if (!strcmp(argv[i], "base64")) {
+                                format = FORMAT_BASE64;
+                            } else if (!strcmp(argv[i], "png-uri")) {
+                                format = FORMAT_PNG_URI;
+                            } else if (!strcmp(argv[i], "svg-uri")) {
+                                format = FORMAT_SVG_URI;
+                            } else {
                                 fprintf(stderr, "%s: Unsupported format '%s'.\n", progname, argv[i]);
                                 return 1;
                             }
                         }
                         break;
 
+                    case 'p' : /* -p PITCH */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing pitch after '-p'.\n", progname);
+                            return 1;
+                        } else {
+                            long tempval = strtol(argv[i], NULL, 10);
+                            if (tempval < 1 || tempval > 65535) {
+                                fprintf(stderr, "%s: Bad pitch '-p %s'.\n", progname, argv[i]);
+                                return 1;
+                            }
+                            pitch = (uint16_t)tempval;
+                        }
+                        break;
+
+                    case 'r' : /* -r ROWS */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing rows after '-r'.\n", progname);
+                            return 1;
+                        } else {
+                            long tempval = strtol(argv[i], NULL, 10);
+                            if (tempval < 1 || tempval > 100) {
+                                fprintf(stderr, "%s: Bad rows '-r %s'.\n", progname, argv[i]);
+                                return 1;
+                            }
+                            rows = (uint16_t)tempval;
+                        }
+                        break;
+
+                    case 's' : /* -s SCALE */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing scale after '-s'.\n", progname);
+                            return 1;
+                        } else {
+                            long tempval = strtol(argv[i], NULL, 10);
+                            if (tempval < 1 || tempval > 255) {
+                                fprintf(stderr, "%s: Bad scale '-s %s'.\n", progname, argv[i]);
+                                return 1;
+                            }
+                            scale = (uint8_t)tempval;
+                        }
+                        break;
+
+                    case 't' : /* -t TRANSFORM */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing transform after '-t'.\n", progname);
+                            return 1;
+                        } else if (!strcmp(argv[i], "rotate-90")) {
+                            transform = QRCODE_ROTATE_90;
+                        } else if (!strcmp(argv[i], "rotate-180")) {
+                            transform = QRCODE_ROTATE_180;
+                        } else if (!strcmp(argv[i], "rotate-270")) {
+                            transform = QRCODE_ROTATE_270;
+                        } else if (!strcmp(argv[i], "transpose")) {
+                            transform = QRCODE_TRANSPOSE;
+                        } else if (!strcmp(argv[i], "mirror")) {
+                            transform = QRCODE_MIRROR;
+                        } else if (!strcmp(argv[i], "flip")) {
+                            transform = QRCODE_FLIP;
+                        } else if (!strcmp(argv[i], "invert")) {
+                            transform = QRCODE_INVERT;
+                        } else {
+                            fprintf(stderr, "%s: Bad transform '-t %s'.\n", progname, argv[i]);
+                            return 1;
+                        }
+                        break;
+
+                    case 'w' : /* -w WIDTH */
+                        i ++;
+                        if (i >= argc) {
+                            fprintf(stderr, "%s: Missing width after '-w'.\n", progname);
+                            return 1;
+                        } else {
+                            long tempval = strtol(argv[i], NULL, 10);
+                            if (tempval < 1 || tempval > 32767) {
+                                fprintf(stderr, "%s: Bad width '-w %s'.\n", progname, argv[i]);
+                                return 1;
+                            }
+                            width = (uint16_t)tempval;
+                        }
+                        break;
+
                     case 'v' : /* -v VERSION */
                         i ++;
                         if (i >= argc) {
@@ -137,242 +353,324 @@ int main(int argc, char *argv[]) {
 
     // Verify we have something to generate...
     if (text == NULL) {
-        fprintf(stderr, "Usage: %s [-e ECC] [-v VERSION] TEXT >FILENAME.svg\n", progname);
+        fprintf(stderr, "Usage: %s [OPTIONS] TEXT >FILENAME.{png,tiff,pbm,pgm,bmp,svg,eps,txt,gcode,pdf,prn,zpl}\n", progname);
         fputs("Options:\n", stderr);
+        fputs("-b BORDER   Specify quiet zone in modules (default is 4)\n", stderr);
+        fputs("-c COLUMNS  Specify PDF labels across a page (default is 3)\n", stderr);
         fputs("-e ECC      Specify error correction (low,medium,quartile,high)\n", stderr);
-        fputs("-e VERSION  Specify version/size (1 to 40, default is auto)\n", stderr);
+        fputs("-f FORMAT   Specify output format (png,tiff,pbm,pgm,bmp,svg,eps,\n            outline,polyline,gcode,pdf,escpos,escpos-column,zpl,\n            text,text-invert,ansi,gray-png,gray-pgm,hex,base64,\n            png-uri,svg-uri)\n", stderr);
+        fputs("-p PITCH    Specify G-code module pitch in micrometres (default is 250)\n", stderr);
+        fputs("-r ROWS     Specify PDF labels down a page (default is 10)\n", stderr);
+        fputs("-s SCALE    Specify size of modules in pixels (default is 5)\n", stderr);
+        fputs("-t XFORM    Transform the symbol (rotate-90,rotate-180,rotate-270,\n            transpose,mirror,flip,invert)\n", stderr);
+        fputs("-v VERSION  Specify version/size (1 to 40, default is auto)\n", stderr);
+        fputs("-w WIDTH    Specify anti-aliased image width in pixels\n", stderr);
         return 1;
     }
 
+    // A PDF label sheet of every line on the standard input...
+    if (format == FORMAT_PDF) {
+        QRCode   *qrcodes;              // QR codes
+        uint16_t count;                 // Number of QR codes
+        int8_t   status;                // Write status
+
+        if (!strcmp(text, "-")) {
+            if ((qrcodes = read_codes(stdin, version, ecc, &count)) == NULL) {
+                fprintf(stderr, "%s: Unable to generate QR codes.\n", progname);
+                return 1;
+            }
+        } else if (qrcode_initText(&qrcode, qrcodeBytes, version, ecc, text) < 0) {
+            fprintf(stderr, "%s: Unable to generate QR code.\n", progname);
+            return 1;
+        } else {
+            qrcodes = &qrcode;
+            count = 1;
+        }
+
+        status = qrcode_writePDF(qrcodes, count, columns, rows, QR_PAGE_W, QR_PAGE_H, border, write_cb, stdout);
+        fflush(stdout);
+
+        if (qrcodes != &qrcode) {
+            for (uint16_t j = 0; j < count; j ++)
+              free(qrcodes[j].modules);
+            free(qrcodes);
+        }
+
+        if (status < 0) {
+            fprintf(stderr, "%s: Unable to write PDF.\n", progname);
+            return 1;
+        }
+
+        return 0;
+    }
+
     // Generate QR code...
     if (qrcode_initText(&qrcode, qrcodeBytes, version, ecc, text) < 0) {
         fprintf(stderr, "%s: Unable to generate QR code.\n", progname);
         return 1;
     }
 
-    if (makeSVG) {
-	// Write SVG to stdout...
-	printf("<svg width=\"%d\" height=\"%d\" xmlns=\"http://www.w3.org/2000/svg\">\n", (qrcode.size + 2 * QR_PADDING) * QR_SCALE, (qrcode.size + 2 * QR_PADDING) * QR_SCALE);
-	printf("  <rect x=\"0\" y=\"0\" width=\"%d\" height=\"%d\" fill=\"white\" />\n", (qrcode.size + 2 * QR_PADDING) * QR_SCALE, (qrcode.size + 2 * QR_PADDING) * QR_SCALE);
-
-	for (uint8_t y = 0; y < qrcode.size; y++) {
-	    uint8_t xstart = 0, xcount = 0;
-
-	    for (uint8_t x = 0; x < qrcode.size; x++) {
-		if (qrcode_getModule(&qrcode, x, y)) {
-		    if (xcount == 0) { xstart = x; }
-		    xcount ++;
-		} else if (xcount > 0) {
-		    printf("  <rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"black\" />\n", (xstart + QR_PADDING) * QR_SCALE, (y + QR_PADDING) * QR_SCALE, xcount * QR_SCALE, QR_SCALE);
-		    xcount = 0;
-		}
-	    }
-
-	    if (xcount > 0) {
-		printf("  <rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"black\" />\n", (xstart + QR_PADDING) * QR_SCALE, (y + QR_PADDING) * QR_SCALE, xcount * QR_SCALE, QR_SCALE);
-	    }
-	}
-
-	puts("</svg>");
-    } else {
-        // Write PNG to stdout...
-        unsigned char	pngbuf[65536],	// PNG output buffer
-			*pngptr = pngbuf,
-					// Pointer into PNG buffer
-			*pngend = pngbuf + sizeof(pngbuf),
-					// Pointer to end of PNG buffer
-			*pngdata,	// Start of PNG chunk data
-			line[1 + (QR_SCALE * (255 + 2 * QR_PADDING) + 7) / 8],
-					// PNG bitmap line starting with filter byte
-			*lineptr,	// Pointer into line
-			bit;		// Current bit
-        unsigned	size = QR_SCALE * (qrcode.size + 2 * QR_PADDING),
-					// Size of image
-			linelen = (size + 7) / 8,
-					// Length of a line
-			x, x0, y, y0,	// Looping vars
-			xoff = (QR_SCALE * QR_PADDING) / 8,
-			xmod = (QR_SCALE * QR_PADDING) & 7;
-        int		zerr;		// ZLIB error code
-	z_stream	zstream;	// ZLIB compression stream
-
-
-        // Add the PNG file header...
-        *pngptr++ = 137;
-        *pngptr++ = 80;
-        *pngptr++ = 78;
-        *pngptr++ = 71;
-        *pngptr++ = 13;
-        *pngptr++ = 10;
-        *pngptr++ = 26;
-        *pngptr++ = 10;
-
-        // Add the IHDR chunk...
-        pngptr    = png_add_unsigned(13, pngptr, pngend);
-        pngdata   = pngptr;
-
-        *pngptr++ = 'I';
-        *pngptr++ = 'H';
-        *pngptr++ = 'D';
-        *pngptr++ = 'R';
-
-        pngptr    = png_add_unsigned(size, pngptr, pngend);
-					// Width
-        pngptr    = png_add_unsigned(size, pngptr, pngend);
-					// Height
-        *pngptr++ = 1;			// Bit depth
-        *pngptr++ = 0;			// Color type grayscale
-        *pngptr++ = 0;			// Compression method 0 (deflate)
-        *pngptr++ = 0;			// Filter method 0 (adaptive)
-        *pngptr++ = 0;			// Interlace method 0 (no interlace)
-        pngptr    = png_add_crc(pngdata, pngptr, pngend);
-
-        // Add the IDAT chunk...
-        pngptr    += 4;			// Leave room for length
-        pngdata   = pngptr;
-
-        *pngptr++ = 'I';
-        *pngptr++ = 'D';
-        *pngptr++ = 'A';
-        *pngptr++ = 'T';
-
-        // Initialize zlib compressor...
-        if ((zerr = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, /*windowBits*/11, /*memLevel*/7, Z_DEFAULT_STRATEGY)) < Z_OK) {
-            fprintf(stderr, "%s: Unable to create deflate stream (%d).\n", progname, zerr);
-            return 1;
-        }
+    qrcode_transform(&qrcode, transform);
 
-        zstream.next_in   = (Bytef *)line;
-        zstream.next_out  = (Bytef *)pngptr;
-        zstream.avail_out = (uInt)(sizeof(pngbuf) - (pngptr - pngbuf));
+    switch (format) {
+        case FORMAT_PNG :
+            if (qrcode_writePNG(&qrcode, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write PNG image.\n", progname);
+                return 1;
+            }
+            break;
 
-        // All lines start with the "None" (0) filter...
-        line[0] = 0;
+        case FORMAT_SVG :
+            if (qrcode_writeSVG(&qrcode, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write SVG image.\n", progname);
+                return 1;
+            }
+            break;
 
-        // Add padding at the top...
-        memset(line + 1, 0xff, linelen);
-        for (y = 0; y < (QR_SCALE * QR_PADDING); y ++) {
-	    zstream.next_in  = (Bytef *)line;
-            zstream.avail_in = linelen + 1;
-            if ((zerr = deflate(&zstream, Z_NO_FLUSH)) < Z_OK) {
-                fprintf(stderr, "%s: Unable to deflate image (%d).\n", progname, zerr);
+        case FORMAT_TIFF :
+            if (qrcode_writeTIFF(&qrcode, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write TIFF image.\n", progname);
                 return 1;
             }
-        }
+            break;
 
-        // Add lines from the QR code...
-        for (y = 0; y < qrcode.size; y ++) {
-	    memset(line + 1, 0xff, linelen);
-
-	    for (x = 0, lineptr = line + 1 + xoff, bit = 128 >> xmod; x < qrcode.size; x ++) {
-		bool qrset = qrcode_getModule(&qrcode, x, y);
-
-		for (x0 = 0; x0 < QR_SCALE; x0 ++) {
-		    if (qrset) {
-			*lineptr ^= bit;
-		    }
-
-		    if (bit == 1) {
-			lineptr ++;
-			bit = 128;
-		    } else {
-			bit = bit / 2;
-		    }
-		}
-	    }
-
-	    for (y0 = 0; y0 < QR_SCALE; y0 ++) {
-		zstream.next_in  = (Bytef *)line;
-		zstream.avail_in = linelen + 1;
-		if ((zerr = deflate(&zstream, Z_NO_FLUSH)) < Z_OK) {
-		    fprintf(stderr, "%s: Unable to deflate image (%d).\n", progname, zerr);
-		    return 1;
-		}
-	    }
-        }
+        case FORMAT_PBM :
+        case FORMAT_PGM :
+        case FORMAT_BMP :
+            if (!render_image(&qrcode, format == FORMAT_PBM ? QRCODE_IMAGE_PBM : format == FORMAT_PGM ? QRCODE_IMAGE_PGM : QRCODE_IMAGE_BMP, scale, border, stdout)) {
+                fprintf(stderr, "%s: Unable to write image.\n", progname);
+                return 1;
+            }
+            break;
 
-        // Add padding at the bottom...
-        memset(line + 1, 0xff, linelen);
-        for (y = 0; y < (QR_SCALE * QR_PADDING); y ++) {
-	    zstream.next_in  = (Bytef *)line;
-            zstream.avail_in = linelen + 1;
-            if ((zerr = deflate(&zstream, Z_NO_FLUSH)) < Z_OK) {
-                fprintf(stderr, "%s: Unable to deflate image (%d).\n", progname, zerr);
+        case FORMAT_ESCPOS :
+        case FORMAT_ESCPOS_COLUMN :
+            if (qrcode_writeESCPOS(&qrcode, format == FORMAT_ESCPOS ? QRCODE_ESCPOS_RASTER : QRCODE_ESCPOS_COLUMN, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write ESC/POS image.\n", progname);
                 return 1;
             }
-        }
+            break;
 
-        // Finish compression...
-	zstream.next_in  = (Bytef *)line;
-	zstream.avail_in = 0;
-	if ((zerr = deflate(&zstream, Z_FINISH)) != Z_STREAM_END) {
-	    fprintf(stderr, "%s: Unable to end image (%d).\n", progname, zerr);
-	    return 1;
-	}
+        case FORMAT_ZPL :
+            if (qrcode_writeZPL(&qrcode, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write ZPL label.\n", progname);
+                return 1;
+            }
+            break;
 
-        pngptr = (unsigned char *)zstream.next_out;
+        case FORMAT_TEXT :
+        case FORMAT_TEXT_INVERT :
+        case FORMAT_ANSI :
+            if (qrcode_writeText(&qrcode, format == FORMAT_TEXT ? 0 : format == FORMAT_TEXT_INVERT ? QRCODE_TEXT_INVERT : QRCODE_TEXT_ANSI, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write text.\n", progname);
+                return 1;
+            }
+            break;
 
-        png_add_unsigned((unsigned)(pngptr - pngdata - 4), pngdata - 4, pngend);
-        pngptr = png_add_crc(pngdata, pngptr, pngend);
+        case FORMAT_GRAY_PNG :
+        case FORMAT_GRAY_PGM :
+            if (width == 0) {
+                width = (uint16_t)(scale * (qrcode.size + 2 * border));
+            }
 
-        // Add the IEND chunk...
-        pngptr  = png_add_unsigned(0, pngptr, pngend);
-        pngdata = pngptr;
+            if ((format == FORMAT_GRAY_PNG ? qrcode_writeGrayPNG(&qrcode, width, border, write_cb, stdout) : qrcode_writePGM(&qrcode, width, border, write_cb, stdout)) < 0) {
+                fprintf(stderr, "%s: Unable to write anti-aliased image.\n", progname);
+                return 1;
+            }
+            break;
 
-        *pngptr++ = 'I';
-        *pngptr++ = 'E';
-        *pngptr++ = 'N';
-        *pngptr++ = 'D';
+        case FORMAT_HEX :
+        case FORMAT_BASE64 :
+            {
+                char modules[format == FORMAT_HEX ? qrcode_getHexLength(&qrcode) : qrcode_getBase64Length(&qrcode)];
 
-        pngptr    = png_add_crc(pngdata, pngptr, pngend);
+                if (format == FORMAT_HEX) {
+                    qrcode_getHex(&qrcode, modules);
+                } else {
+                    qrcode_getBase64(&qrcode, modules);
+                }
+                puts(modules);
+            }
+            break;
+
+        case FORMAT_PNG_URI :
+        case FORMAT_SVG_URI :
+            {
+                uint8_t uriFormat = format == FORMAT_PNG_URI ? QRCODE_URI_PNG : QRCODE_URI_SVG;
+                uint32_t length = qrcode_getDataURILength(&qrcode, uriFormat, scale, border);
+                char *uri = length > 0 ? malloc(length) : NULL;
+
+                if (!uri || qrcode_getDataURI(&qrcode, uriFormat, scale, border, uri, length) < 0) {
+                    fprintf(stderr, "%s: Unable to write data URI.\n", progname);
+                    free(uri);
+                    return 1;
+                }
+                puts(uri);
+                free(uri);
+            }
+            break;
 
-        // Write the PNG file to stdout...
-        fwrite(pngbuf, (size_t)(pngptr - pngbuf), 1, stdout);
-        fflush(stdout);
+        case FORMAT_EPS :
+            if (qrcode_writeEPS(&qrcode, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write EPS image.\n", progname);
+                return 1;
+            }
+            break;
+
+        case FORMAT_OUTLINE :
+            if (qrcode_writeSVGOutline(&qrcode, scale, border, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write SVG outlines.\n", progname);
+                return 1;
+            }
+            break;
+
+        case FORMAT_POLYLINE :
+            if (qrcode_writePolylines(&qrcode, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write polylines.\n", progname);
+                return 1;
+            }
+            break;
+
+        case FORMAT_GCODE :
+            if (qrcode_writeGCode(&qrcode, pitch, QR_FEED, write_cb, stdout) < 0) {
+                fprintf(stderr, "%s: Unable to write G-code.\n", progname);
+                return 1;
+            }
+            break;
     }
+    fflush(stdout);
 
     return 0;
 }
 
 
 //
-// 'png_add_crc()' - Compute and append the chunk data CRC.
+// 'render_image()' - Render an uncompressed image into a mapping of a file.
+//
+// A regular file opened for reading and writing (e.g. "1<>FILENAME") is sized up
+// front and mapped so the image is rendered in place; otherwise the image goes into
+// an anonymous mapping that is written afterwards.
 //
 
-static unsigned char *			// O - Next byte in output buffer
-png_add_crc(unsigned char *pngdata,	// I - Pointer to start of chunk data
-            unsigned char *pngptr,	// I - Pointer to end of chunk data (where CRC goes)
-            unsigned char *pngend)	// I - Pointer to end of PNG output buffer
+static bool				// O - `true` on success, `false` on error
+render_image(QRCode  *qrcode,		// I - QR code
+             uint8_t format,		// I - QRCODE_IMAGE_xxx format
+             uint8_t scale,		// I - Size of modules
+             uint8_t border,		// I - Quiet zone
+             FILE    *fp)		// I - Output file
 {
-  unsigned		c;		// CRC value
+  uint32_t	size;			// Size of image file
+  int		fd = fileno(fp);	// Output file descriptor
+  struct stat	info;			// Output file information
+  off_t		offset,			// Current file offset
+		base;			// Page-aligned offset to map
+  bool		ret;			// Return value
+  uint8_t	*buffer = MAP_FAILED;	// Image data
+
+
+  if ((size = qrcode_getImageSize(qrcode, format, scale, border)) == 0)
+    return (false);
+
+  fflush(fp);
+  offset = lseek(fd, 0, SEEK_CUR);
+  base   = offset < 0 ? 0 : offset - offset % sysconf(_SC_PAGESIZE);
 
+  if (offset >= 0 && !fstat(fd, &info) && S_ISREG(info.st_mode) && !ftruncate(fd, offset + (off_t)size))
+    buffer = mmap(NULL, size + (size_t)(offset - base), PROT_READ | PROT_WRITE, MAP_SHARED, fd, base);
 
-  c = crc32(0, Z_NULL, 0);
-  c = crc32(c, pngdata, (uInt)(pngptr - pngdata));
+  if (buffer != MAP_FAILED)
+  {
+    // Render straight into the file...
+    ret = !qrcode_renderImage(qrcode, format, scale, border, buffer + (offset - base), size);
 
-  // Append the CRC to the buffer...
-  return (png_add_unsigned(c, pngptr, pngend));
+    munmap(buffer, size + (size_t)(offset - base));
+    lseek(fd, offset + (off_t)size, SEEK_SET);
+  }
+  else
+  {
+    // Not mappable (a pipe, or write-only), so render and then write...
+    if ((buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+      return (false);
+
+    ret = !qrcode_renderImage(qrcode, format, scale, border, buffer, size) && fwrite(buffer, 1, size, fp) == size;
+
+    munmap(buffer, size);
+  }
+
+  return (ret);
 }
 
 
 //
-// 'png_add_unsigned()' - Add a 32-bit unsigned integer to the PNG buffer.
+// 'write_cb()' - Write image data to a stdio file.
 //
 
-static unsigned char *			// O - Next byte in output buffer
-png_add_unsigned(unsigned      val,	// I - Value to append
-                 unsigned char *pngptr,	// I - Pointer into output buffer
-                 unsigned char *pngend)	// I - Pointer to end of output buffer
+static bool				// O - `true` on success, `false` on error
+write_cb(void          *ctx,		// I - Output file
+         const uint8_t *data,		// I - Data to write
+         size_t        length)		// I - Number of bytes
 {
-  // Append the value to the buffer...
-  if (pngptr < pngend)
-    *pngptr++ = (val >> 24) & 0xff;
-  if (pngptr < pngend)
-    *pngptr++ = (val >> 16) & 0xff;
-  if (pngptr < pngend)
-    *pngptr++ = (val >> 8) & 0xff;
-  if (pngptr < pngend)
-    *pngptr++ = val & 0xff;
-
-  return (pngptr);
+  return (fwrite(data, 1, length, (FILE *)ctx) == length);
+}
+
+
+//
+// 'read_codes()' - Generate a QR code for each line of a file.
+//
+
+static QRCode *				// O - QR codes or `NULL` on error
+read_codes(FILE     *fp,		// I - File to read
+           uint8_t  version,		// I - Version/size
+           uint8_t  ecc,		// I - Error correction level
+           uint16_t *count)		// O - Number of QR codes
+{
+  QRCode	*qrcodes = NULL,	// QR codes
+		*temp;			// New QR codes
+  size_t	alloc = 0;		// Allocated QR codes
+  char		line[4096],		// Line from file
+		*ptr;			// Pointer into line
+  uint8_t	buffer[qrcode_getBufferSize(VERSION_MAX)];
+					// QR code buffer
+
+
+  *count = 0;
+
+  while (fgets(line, sizeof(line), fp))
+  {
+    if ((ptr = strchr(line, '\n')) != NULL)
+      *ptr = '\0';
+    if (!line[0])
+      continue;
+
+    if (*count == 65535)
+      break;
+
+    if (*count >= alloc)
+    {
+      alloc += 1024;
+      if ((temp = realloc(qrcodes, alloc * sizeof(QRCode))) == NULL)
+        break;
+      qrcodes = temp;
+    }
+
+    // Generate into a full size buffer, then keep only what this version needs...
+    if (qrcode_initText(qrcodes + *count, buffer, version, ecc, line) < 0)
+      break;
+
+    size_t bytes = qrcode_getBufferSize(qrcodes[*count].version);
+    if ((qrcodes[*count].modules = malloc(bytes)) == NULL)
+      break;
+    memcpy(qrcodes[*count].modules, buffer, bytes);
+    (*count) ++;
+  }
+
+  if (!feof(fp) || *count == 0)
+  {
+    while (*count > 0)
+      free(qrcodes[-- *count].modules);
+    free(qrcodes);
+    return (NULL);
+  }
+
+  return (qrcodes);
 }
@@ -0,0 +1,2116 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The writers are included directly so their checksum and Huffman helpers can be tested
+#include "../src/qrcode_output.c"
+
+typedef std::vector<uint8_t> Bytes;
+
+static int total = 0, passed = 0;
+
+// Counts a test case, describing it when any modules or pixels are wrong.
+static void result(uint32_t wrong, const char *format, ...) {
+    va_list ap;
+
+    total++;
+    if (wrong == 0) {
+        passed++;
+        return;
+    }
+
+    printf("Failed ");
+    va_start(ap, format);
+    vprintf(format, ap);
+    va_end(ap);
+    printf(", wrong=%u\n", wrong);
+}
+
+// Runs a test on a symbol of every version and error correction level; the symbols are
+// only generated once.
+static void forEachSymbol(void (*test)(QRCode *qrcode)) {
+    static std::vector<QRCode> qrcodes;
+    static std::vector<Bytes> buffers;
+
+    if (qrcodes.empty()) {
+        for (uint8_t version = 1; version <= 40; version++) {
+            if (LOCK_VERSION != 0 && LOCK_VERSION != version) { continue; }
+
+            for (uint8_t ecc = 0; ecc < 4; ecc++) {
+                QRCode qrcode;
+                buffers.push_back(Bytes(qrcode_getBufferSize(version)));
+                qrcode_initText(&qrcode, buffers.back().data(), version, ecc, "HELLO");
+                qrcodes.push_back(qrcode);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < qrcodes.size(); i++) { test(&qrcodes[i]); }
+}
+
+// Returns the modules as one byte each, for tests that look them up for every pixel.
+static Bytes getModules(QRCode *qrcode) {
+    Bytes modules((size_t)qrcode->size * qrcode->size);
+    for (uint8_t y = 0; y < qrcode->size; y++) {
+        for (uint8_t x = 0; x < qrcode->size; x++) { modules[y * qrcode->size + x] = qrcode_getModule(qrcode, x, y); }
+    }
+    return modules;
+}
+
+static bool append_cb(void *ctx, const uint8_t *data, size_t length) {
+    Bytes *bytes = (Bytes *)ctx;
+    bytes->insert(bytes->end(), data, data + length);
+    return true;
+}
+
+static uint32_t getUInt32(const uint8_t *data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static uint32_t getUInt32LE(const uint8_t *data) {
+    return ((uint32_t)data[3] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[1] << 8) | data[0];
+}
+
+// Plain bit at a time CRC-32 and byte at a time Adler-32, independent of the library's
+static uint32_t crc32(const uint8_t *data, size_t length) {
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) { crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0); }
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t length) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < length; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+
+#pragma mark - Inflate
+
+// A small inflater (RFC 1951) for checking compressed output
+
+typedef struct Inflater {
+    const uint8_t *data;
+    size_t length, offset;
+    uint32_t bits;
+    uint8_t bitCount;
+    bool ok;
+    Bytes out;
+} Inflater;
+
+typedef struct Huffman {
+    uint16_t counts[16];
+    uint16_t symbols[288];
+} Huffman;
+
+static uint32_t inflate_getBits(Inflater *in, uint8_t count) {
+    while (in->bitCount < count) {
+        if (in->offset >= in->length) { in->ok = false; return 0; }
+        in->bits |= (uint32_t)in->data[in->offset++] << in->bitCount;
+        in->bitCount += 8;
+    }
+
+    uint32_t value = in->bits & ((1u << count) - 1);
+    in->bits >>= count;
+    in->bitCount -= count;
+    return value;
+}
+
+// Builds canonical codes; returns false for an over-subscribed set of lengths.
+static bool huffman_build(Huffman *h, const uint8_t *lengths, uint16_t count) {
+    uint16_t offsets[16];
+
+    memset(h->counts, 0, sizeof(h->counts));
+    for (uint16_t i = 0; i < count; i++) { h->counts[lengths[i]]++; }
+    h->counts[0] = 0;
+
+    int32_t left = 1;
+    for (uint8_t len = 1; len < 16; len++) {
+        left = left * 2 - h->counts[len];
+        if (left < 0) { return false; }
+    }
+
+    offsets[1] = 0;
+    for (uint8_t len = 1; len < 15; len++) { offsets[len + 1] = offsets[len] + h->counts[len]; }
+    for (uint16_t i = 0; i < count; i++) {
+        if (lengths[i]) { h->symbols[offsets[lengths[i]]++] = i; }
+    }
+
+    return true;
+}
+
+static int32_t huffman_decode(Inflater *in, const Huffman *h) {
+    int32_t code = 0, first = 0, index = 0;
+
+    for (uint8_t len = 1; len < 16; len++) {
+        code |= (int32_t)inflate_getBits(in, 1);
+        int32_t count = h->counts[len];
+        if (code - first < count) { return h->symbols[index + code - first]; }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    in->ok = false;
+    return -1;
+}
+
+static bool inflate_codes(Inflater *in, const Huffman *lit, const Huffman *dist) {
+    static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    while (in->ok) {
+        int32_t symbol = huffman_decode(in, lit);
+        if (symbol < 0 || symbol > 285) { return false; }
+        if (symbol < 256) { in->out.push_back((uint8_t)symbol); continue; }
+        if (symbol == 256) { return in->ok; }
+
+        symbol -= 257;
+        uint32_t length = lengthBase[symbol] + inflate_getBits(in, lengthExtra[symbol]);
+        int32_t code = huffman_decode(in, dist);
+        if (code < 0 || code > 29) { return false; }
+
+        uint32_t distance = distBase[code] + inflate_getBits(in, distExtra[code]);
+        if (distance > in->out.size()) { return false; }
+        for (uint32_t i = 0; i < length; i++) { in->out.push_back(in->out[in->out.size() - distance]); }
+    }
+
+    return false;
+}
+
+static bool inflate_dynamic(Inflater *in) {
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    uint8_t lengths[286 + 30];
+    Huffman lencode, lit, dist;
+
+    uint16_t nlen = (uint16_t)inflate_getBits(in, 5) + 257;
+    uint16_t ndist = (uint16_t)inflate_getBits(in, 5) + 1;
+    uint16_t ncode = (uint16_t)inflate_getBits(in, 4) + 4;
+    if (nlen > 286 || ndist > 30) { return false; }
+
+    memset(lengths, 0, sizeof(lengths));
+    for (uint16_t i = 0; i < ncode; i++) { lengths[order[i]] = (uint8_t)inflate_getBits(in, 3); }
+    if (!huffman_build(&lencode, lengths, 19)) { return false; }
+
+    for (uint16_t i = 0; in->ok && i < nlen + ndist; ) {
+        int32_t symbol = huffman_decode(in, &lencode);
+        if (symbol < 0) { return false; }
+        if (symbol < 16) { lengths[i++] = (uint8_t)symbol; continue; }
+
+        uint8_t value = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+            if (i == 0) { return false; }
+            value = lengths[i - 1];
+            repeat = 3 + inflate_getBits(in, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + inflate_getBits(in, 3);
+        } else {
+            repeat = 11 + inflate_getBits(in, 7);
+        }
+        if (i + repeat > (uint32_t)(nlen + ndist)) { return false; }
+        while (repeat-- > 0) { lengths[i++] = value; }
+    }
+
+    if (!huffman_build(&lit, lengths, nlen) || !huffman_build(&dist, lengths + nlen, ndist)) { return false; }
+    return inflate_codes(in, &lit, &dist);
+}
+
+static bool inflate_fixed(Inflater *in) {
+    uint8_t lengths[288];
+    Huffman lit, dist;
+
+    for (uint16_t i = 0; i < 288; i++) { lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8; }
+    huffman_build(&lit, lengths, 288);
+    for (uint16_t i = 0; i < 30; i++) { lengths[i] = 5; }
+    huffman_build(&dist, lengths, 30);
+
+    return inflate_codes(in, &lit, &dist);
+}
+
+static bool inflate_stored(Inflater *in) {
+    in->bits = 0;
+    in->bitCount = 0;
+    if (in->offset + 4 > in->length) { return false; }
+
+    uint16_t length = in->data[in->offset] | (in->data[in->offset + 1] << 8);
+    uint16_t check = in->data[in->offset + 2] | (in->data[in->offset + 3] << 8);
+    in->offset += 4;
+    if ((uint16_t)~length != check || in->offset + length > in->length) { return false; }
+
+    in->out.insert(in->out.end(), in->data + in->offset, in->data + in->offset + length);
+    in->offset += length;
+    return true;
+}
+
+// Inflates a zlib stream, checking its header and Adler-32 trailer.
+static bool zlib_inflate(const uint8_t *data, size_t length, Bytes *out) {
+    if (length < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+        return false;
+    }
+
+    Inflater in;
+    in.data = data + 2;
+    in.length = length - 6;
+    in.offset = 0;
+    in.bits = 0;
+    in.bitCount = 0;
+    in.ok = true;
+
+    bool last = false;
+    while (!last && in.ok) {
+        last = inflate_getBits(&in, 1);
+        switch (inflate_getBits(&in, 2)) {
+            case 0:
+                if (!inflate_stored(&in)) { return false; }
+                break;
+            case 1:
+                if (!inflate_fixed(&in)) { return false; }
+                break;
+            case 2:
+                if (!inflate_dynamic(&in)) { return false; }
+                break;
+            default:
+                return false;
+        }
+    }
+
+    // All of the data must have been used, then the Adler-32 of the output
+    if (!in.ok || in.offset != in.length) { return false; }
+    if (getUInt32(data + length - 4) != adler32(in.out.data(), in.out.size())) { return false; }
+
+    *out = in.out;
+    return true;
+}
+
+
+#pragma mark - PNG
+
+// Decodes a grayscale PNG, checking the chunk CRCs, and returns the unfiltered image.
+static bool png_decode(const Bytes &png, uint32_t *width, uint32_t *height, uint8_t *depth, Bytes *pixels) {
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    if (png.size() < 8 || memcmp(png.data(), signature, 8)) { return false; }
+
+    Bytes idat;
+    bool ended = false;
+    for (size_t offset = 8; !ended; ) {
+        if (offset + 12 > png.size()) { return false; }
+        uint32_t length = getUInt32(&png[offset]);
+        if (offset + 12 + length > png.size()) { return false; }
+
+        const uint8_t *type = &png[offset + 4], *data = type + 4;
+        if (getUInt32(data + length) != crc32(type, length + 4)) { return false; }
+
+        if (!memcmp(type, "IHDR", 4)) {
+            if (length != 13 || data[9] != 0 || data[10] || data[11] || data[12]) { return false; }
+            *width = getUInt32(data);
+            *height = getUInt32(data + 4);
+            *depth = data[8];
+        } else if (!memcmp(type, "IDAT", 4)) {
+            idat.insert(idat.end(), data, data + length);
+        } else if (!memcmp(type, "IEND", 4)) {
+            ended = offset + 12 == png.size();
+            if (!ended) { return false; }
+        }
+        offset += 12 + length;
+    }
+
+    Bytes raw;
+    if (!zlib_inflate(idat.data(), idat.size(), &raw)) { return false; }
+
+    uint32_t rowBytes = (*width * *depth + 7) / 8;
+    if (raw.size() != (size_t)(rowBytes + 1) * *height) { return false; }
+
+    pixels->assign((size_t)rowBytes * *height, 0);
+    for (uint32_t y = 0; y < *height; y++) {
+        const uint8_t *line = &raw[(size_t)y * (rowBytes + 1)];
+        uint8_t *row = &(*pixels)[(size_t)y * rowBytes];
+        for (uint32_t x = 0; x < rowBytes; x++) {
+            switch (line[0]) {
+                case 0:
+                    row[x] = line[1 + x];
+                    break;
+                case 2:
+                    row[x] = line[1 + x] + (y > 0 ? (row - rowBytes)[x] : 0);
+                    break;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// Inflates a 1-bit PNG and compares every pixel with qrcode_getModule.
+static void testPNG(QRCode *qrcode) {
+    // Scaled rows are Up filtered and quiet zones repeated, so cover long runs of both
+    static const uint8_t scales[] = { 1, 2, 3, 8 };
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t s = 0; s < sizeof(scales); s++) {
+        uint8_t scale = scales[s];
+        for (uint8_t border = 0; border <= 4; border += 4) {
+            Bytes png, pixels;
+            uint32_t width, height, wrong = 0;
+            uint8_t depth;
+            uint32_t size = (uint32_t)scale * (qrcode->size + 2 * border);
+
+            if (qrcode_writePNG(qrcode, scale, border, append_cb, &png) || !png_decode(png, &width, &height, &depth, &pixels) ||
+                width != size || height != size || depth != 1) {
+                wrong = 1 << 20;
+            } else {
+                uint32_t rowBytes = (width + 7) / 8;
+                for (uint32_t y = 0; y < height; y++) {
+                    for (uint32_t x = 0; x < width; x++) {
+                        bool white = pixels[y * rowBytes + x / 8] & (0x80 >> (x % 8));
+                        int mx = (int)(x / scale) - border, my = (int)(y / scale) - border;
+                        bool dark = mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+                        if (white == dark) { wrong++; }
+                    }
+                }
+            }
+
+            result(wrong, "PNG: version=%d, ecc=%d, scale=%d, border=%d", qrcode->version, qrcode->ecc, scale, border);
+
+            // An encoder reused across every image must give the same bytes
+            static QRCodeEncoder encoder;
+            Bytes reused;
+            qrcode_writePNGWithEncoder(qrcode, scale, border, append_cb, &reused, &encoder);
+            result(reused != png, "PNG with encoder: version=%d, ecc=%d, scale=%d, border=%d", qrcode->version, qrcode->ecc, scale, border);
+        }
+    }
+}
+
+
+#pragma mark - SVG
+
+// A small SVG rasterizer for the module-unit drawings the writers produce: paths of
+// horizontal and vertical lines filled with the nonzero rule, and <use> of paths in <defs>.
+
+typedef struct Grid {
+    int32_t width, height;
+    Bytes dark;
+} Grid;
+
+// Returns the value of an attribute of the element starting at "element", or "".
+static std::string svg_getAttribute(const std::string &svg, size_t element, const char *name) {
+    size_t end = svg.find('>', element);
+    std::string key = std::string(" ") + name + "=\"";
+    size_t start = svg.find(key, element);
+    if (start == std::string::npos || start > end) { return ""; }
+    start += key.length();
+    return svg.substr(start, svg.find('"', start) - start);
+}
+
+// Fills a path offset by (ox, oy) into the grid; returns false for anything unexpected.
+static bool svg_fillPath(Grid *grid, const std::string &d, int32_t ox, int32_t oy) {
+    std::vector<int32_t> winding((size_t)grid->height * (grid->width + 1), 0);
+    const char *p = d.c_str();
+    int32_t x = 0, y = 0, startX = 0, startY = 0;
+    char command = 0;
+
+    while (*p) {
+        if (*p == ' ' || *p == ',' || *p == '\n') {
+            p++;
+            continue;
+        }
+        if (strchr("MmHhVvLlZz", *p)) { command = *p++; }
+
+        int32_t nx = x, ny = y;
+        if (command == 'Z' || command == 'z') {
+            nx = startX;
+            ny = startY;
+            command = 0;
+        } else {
+            char *end;
+            int32_t a = (int32_t)strtol(p, &end, 10), b = 0;
+            if (end == p) { return false; }
+            p = end;
+            if (strchr("MmLl", command)) {
+                while (*p == ' ' || *p == ',') { p++; }
+                b = (int32_t)strtol(p, &end, 10);
+                if (end == p) { return false; }
+                p = end;
+            }
+
+            switch (command) {
+                case 'M': nx = ox + a; ny = oy + b; break;
+                case 'm': nx = x + a; ny = y + b; break;
+                case 'L': nx = ox + a; ny = oy + b; break;
+                case 'l': nx = x + a; ny = y + b; break;
+                case 'H': nx = ox + a; break;
+                case 'h': nx = x + a; break;
+                case 'V': ny = oy + a; break;
+                case 'v': ny = y + a; break;
+                default: return false;
+            }
+            if (command == 'M' || command == 'm') {
+                x = startX = nx;
+                y = startY = ny;
+                command = command == 'M' ? 'L' : 'l';
+                continue;
+            }
+        }
+
+        // Only vertical edges change the winding number along a row
+        if (nx != x && ny != y) { return false; }
+        if (nx == x && ny != y) {
+            if (x < 0 || x > grid->width || y < 0 || y > grid->height || ny < 0 || ny > grid->height) { return false; }
+            int32_t direction = ny > y ? 1 : -1;
+            for (int32_t row = ny > y ? y : ny; row < (ny > y ? ny : y); row++) {
+                winding[(size_t)row * (grid->width + 1) + x] += direction;
+            }
+        }
+        x = nx;
+        y = ny;
+    }
+
+    for (int32_t row = 0; row < grid->height; row++) {
+        int32_t sum = 0;
+        for (int32_t col = 0; col < grid->width; col++) {
+            sum += winding[(size_t)row * (grid->width + 1) + col];
+            if (sum != 0) { grid->dark[(size_t)row * grid->width + col] = 1; }
+        }
+    }
+
+    return true;
+}
+
+// Rasterizes an SVG with one grid cell per viewBox unit, checking the pixel size.
+static bool svg_decode(const std::string &svg, uint8_t scale, Grid *grid) {
+    size_t root = svg.find("<svg ");
+    if (root == std::string::npos) { return false; }
+
+    int32_t x0, y0;
+    std::string viewBox = svg_getAttribute(svg, root, "viewBox");
+    if (sscanf(viewBox.c_str(), "%d %d %d %d", &x0, &y0, &grid->width, &grid->height) != 4 || x0 != 0 || y0 != 0) { return false; }
+    if (atoi(svg_getAttribute(svg, root, "width").c_str()) != grid->width * scale ||
+        atoi(svg_getAttribute(svg, root, "height").c_str()) != grid->height * scale) {
+        return false;
+    }
+    grid->dark.assign((size_t)grid->width * grid->height, 0);
+
+    size_t defsEnd = svg.find("</defs>");
+    for (size_t element = svg.find('<', root + 1); element != std::string::npos; element = svg.find('<', element + 1)) {
+        if (svg.compare(element, 6, "<path ") == 0) {
+            if (defsEnd != std::string::npos && element < defsEnd) { continue; }
+            if (!svg_fillPath(grid, svg_getAttribute(svg, element, "d"), 0, 0)) { return false; }
+        } else if (svg.compare(element, 5, "<use ") == 0) {
+            std::string href = svg_getAttribute(svg, element, "xlink:href");
+            if (href.empty()) { href = svg_getAttribute(svg, element, "href"); }
+
+            size_t def = svg.find("id=\"" + href.substr(1) + "\"");
+            if (href.empty() || def == std::string::npos) { return false; }
+            def = svg.rfind('<', def);
+
+            int32_t x = atoi(svg_getAttribute(svg, element, "x").c_str()), y = atoi(svg_getAttribute(svg, element, "y").c_str());
+            if (!svg_fillPath(grid, svg_getAttribute(svg, def, "d"), x, y)) { return false; }
+        }
+    }
+
+    return true;
+}
+
+// Counts the cells that differ from a symbol whose top-left module is at (ox, oy).
+static uint32_t compareGrid(const Grid &grid, QRCode *qrcode, int32_t ox, int32_t oy, int32_t width, int32_t height) {
+    uint32_t wrong = 0;
+    for (int32_t y = 0; y < height; y++) {
+        for (int32_t x = 0; x < width; x++) {
+            bool dark = x >= ox && y >= oy && qrcode_getModule(qrcode, x - ox, y - oy);
+            if ((bool)grid.dark[(size_t)(y * grid.width + x)] != dark) { wrong++; }
+        }
+    }
+    return wrong;
+}
+
+static void testSVG(QRCode *qrcode) {
+    for (uint8_t border = 0; border <= 4; border += 4) {
+        Bytes svg;
+        Grid grid;
+        uint32_t wrong;
+        int32_t units = qrcode->size + 2 * border;
+
+        if (qrcode_writeSVG(qrcode, 3, border, append_cb, &svg) || !svg_decode(std::string(svg.begin(), svg.end()), 3, &grid) ||
+            grid.width != units || grid.height != units) {
+            wrong = 1 << 20;
+        } else {
+            wrong = compareGrid(grid, qrcode, border, border, units, units);
+        }
+
+        result(wrong, "SVG: version=%d, ecc=%d, border=%d", qrcode->version, qrcode->ecc, border);
+    }
+}
+
+// Lays out symbols of different sizes on a sheet and checks each cell.
+static void testSVGSheet() {
+    static const uint8_t versions[] = { 1, 5, 10, 2, 7 };
+    const uint8_t count = sizeof(versions), columns = 2, border = 2;
+    QRCode qrcodes[count];
+    std::vector<Bytes> buffers(count);
+    uint8_t maxSize = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t version = LOCK_VERSION ? LOCK_VERSION : versions[i];
+        buffers[i].resize(qrcode_getBufferSize(version));
+        qrcode_initText(&qrcodes[i], buffers[i].data(), version, i % 4, "HELLO");
+        if (qrcodes[i].size > maxSize) { maxSize = qrcodes[i].size; }
+    }
+
+    Bytes svg;
+    Grid grid;
+    int32_t cell = maxSize + 2 * border;
+    uint32_t wrong = 0;
+
+    if (qrcode_writeSVGSheet(qrcodes, count, columns, 2, border, append_cb, &svg) || !svg_decode(std::string(svg.begin(), svg.end()), 2, &grid) ||
+        grid.width != cell * columns || grid.height != cell * ((count + columns - 1) / columns)) {
+        wrong = 1 << 20;
+    } else {
+        // Each cell is compared through a copy of the grid that starts at the cell
+        for (uint8_t i = 0; i < count; i++) {
+            Grid part = { cell, cell, Bytes() };
+            for (int32_t y = 0; y < cell; y++) {
+                const uint8_t *row = grid.dark.data() + (size_t)((i / columns) * cell + y) * grid.width + (i % columns) * cell;
+                part.dark.insert(part.dark.end(), row, row + cell);
+            }
+            wrong += compareGrid(part, &qrcodes[i], border, border, cell, cell);
+        }
+    }
+
+    result(wrong, "SVG sheet");
+}
+
+static void testAlignmentPositions() {
+    static const uint8_t expected[][8] = {
+        { 1, 0 }, { 2, 6, 18 }, { 7, 6, 22, 38 }, { 32, 6, 34, 60, 86, 112, 138 }, { 40, 6, 30, 58, 86, 114, 142, 170 }
+    };
+
+    for (uint8_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        uint8_t positions[7], count = qrcode_getAlignmentPositions(expected[i][0], positions), wrong = 0;
+        uint8_t expectedCount = 0;
+        while (expectedCount < 7 && expected[i][expectedCount + 1]) { expectedCount++; }
+
+        if (count != expectedCount) {
+            wrong = 1;
+        } else {
+            for (uint8_t j = 0; j < count; j++) { wrong += positions[j] != expected[i][j + 1]; }
+        }
+        result(wrong, "Alignment positions: version=%d", expected[i][0]);
+    }
+}
+
+
+#pragma mark - Rectangles
+
+// Returns true if the module is in a finder or alignment pattern.
+static bool isPattern(QRCode *qrcode, uint8_t x, uint8_t y) {
+    uint8_t size = qrcode->size, align[7], count = qrcode_getAlignmentPositions(qrcode->version, align);
+    if ((x < 7 && y < 7) || (x >= size - 7 && y < 7) || (x < 7 && y >= size - 7)) { return true; }
+
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint8_t j = 0; j < count; j++) {
+            if ((i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0)) { continue; }
+            if (x + 2 >= align[i] && x <= align[i] + 2 && y + 2 >= align[j] && y <= align[j] + 2) { return true; }
+        }
+    }
+    return false;
+}
+
+// Checks that the rectangles cover exactly the dark modules (less the patterns for
+// QRCODE_COVER_DATA), and that the cursor and array forms agree.
+static void testCoverRects(QRCode *qrcode) {
+    for (uint8_t options = QRCODE_COVER_ALL; options <= QRCODE_COVER_DATA; options++) {
+        uint8_t size = qrcode->size;
+        Bytes covered((size_t)size * size, 0);
+        QRCodeRectCursor cursor;
+        QRCodeRect rect;
+        std::vector<QRCodeRect> rects;
+        uint32_t wrong = 0;
+
+        qrcode_rectsBegin(qrcode, &cursor, options);
+        while (qrcode_nextRect(qrcode, &cursor, &rect)) {
+            rects.push_back(rect);
+            if (rect.width == 0 || rect.height == 0 || rect.x + rect.width > size || rect.y + rect.height > size) {
+                wrong++;
+                continue;
+            }
+            for (uint8_t y = rect.y; y < rect.y + rect.height; y++) {
+                for (uint8_t x = rect.x; x < rect.x + rect.width; x++) { covered[y * size + x]++; }
+            }
+        }
+
+        for (uint8_t y = 0; y < size; y++) {
+            for (uint8_t x = 0; x < size; x++) {
+                bool include = qrcode_getModule(qrcode, x, y) && !((options & QRCODE_COVER_DATA) && isPattern(qrcode, x, y));
+                if ((covered[y * size + x] > 0) != include) { wrong++; }
+            }
+        }
+
+        uint16_t count = qrcode_coverRects(qrcode, options, NULL, 0);
+        std::vector<QRCodeRect> array(count + 1);
+        if (count != rects.size() || qrcode_coverRects(qrcode, options, array.data(), count - 1) != count) { wrong++; }
+        qrcode_coverRects(qrcode, options, array.data(), count);
+        if (memcmp(array.data(), rects.data(), count * sizeof(QRCodeRect)) != 0) { wrong++; }
+
+        result(wrong, "Cover rects: version=%d, ecc=%d, options=%d", qrcode->version, qrcode->ecc, options);
+    }
+}
+
+
+#pragma mark - Contours
+
+typedef struct ContourPoint {
+    uint8_t command, x, y;
+} ContourPoint;
+
+static bool contour_cb(void *ctx, uint8_t command, uint8_t x, uint8_t y) {
+    ContourPoint point = { command, x, y };
+    ((std::vector<ContourPoint> *)ctx)->push_back(point);
+    return true;
+}
+
+static bool contourDark(QRCode *qrcode, int x, int y) {
+    return x >= 0 && y >= 0 && x < qrcode->size && y < qrcode->size && qrcode_getModule(qrcode, x, y);
+}
+
+// Checks that the outlines trace every edge between dark and light modules exactly once, with
+// dark on the right, and report only corners.
+static void testContours(QRCode *qrcode) {
+    std::vector<ContourPoint> points;
+    int size = qrcode->size;
+    uint32_t wrong = qrcode_traceContours(qrcode, contour_cb, &points) ? 1 : 0;
+
+    // Horizontal edges are indexed by (x, y) for y in 0..size, vertical by (x, y) for x in 0..size
+    Bytes horizontal((size + 1) * (size + 1), 0), vertical((size + 1) * (size + 1), 0);
+    size_t start = 0;
+
+    for (size_t i = 0; i < points.size(); i++) {
+        const ContourPoint &point = points[i];
+        if (point.command == QRCODE_CONTOUR_MOVE) {
+            start = i;
+            if (i > 0 && points[i - 1].command != QRCODE_CONTOUR_CLOSE) { wrong++; }
+            continue;
+        }
+
+        // Each edge must be a straight line that turns at the next corner
+        const ContourPoint &from = points[i - 1];
+        int dx = (point.x > from.x) - (point.x < from.x), dy = (point.y > from.y) - (point.y < from.y);
+        if (i == start || (dx != 0) == (dy != 0)) {
+            wrong++;
+            continue;
+        }
+        if (point.command == QRCODE_CONTOUR_CLOSE && (point.x != points[start].x || point.y != points[start].y)) { wrong++; }
+
+        for (int x = from.x, y = from.y; x != point.x || y != point.y; x += dx, y += dy) {
+            if (dx) {
+                int left = dx > 0 ? x : x - 1;
+                if (!contourDark(qrcode, left, dx > 0 ? y : y - 1) || contourDark(qrcode, left, dx > 0 ? y - 1 : y)) { wrong++; }
+                horizontal[y * (size + 1) + left]++;
+            } else {
+                int top = dy > 0 ? y : y - 1;
+                if (!contourDark(qrcode, dy > 0 ? x - 1 : x, top) || contourDark(qrcode, dy > 0 ? x : x - 1, top)) { wrong++; }
+                vertical[top * (size + 1) + x]++;
+            }
+        }
+    }
+    if (!points.empty() && points.back().command != QRCODE_CONTOUR_CLOSE) { wrong++; }
+
+    // ...and every edge between dark and light modules is traced exactly once
+    for (int y = 0; y <= size; y++) {
+        for (int x = 0; x <= size; x++) {
+            if (x < size && horizontal[y * (size + 1) + x] != (contourDark(qrcode, x, y) != contourDark(qrcode, x, y - 1))) { wrong++; }
+            if (y < size && vertical[y * (size + 1) + x] != (contourDark(qrcode, x, y) != contourDark(qrcode, x - 1, y))) { wrong++; }
+        }
+    }
+
+    result(wrong, "Contours: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+}
+
+// Fills the outline writers' output and compares it with the symbol.
+static void testOutlines(QRCode *qrcode) {
+    int32_t size = qrcode->size;
+
+    // SVG outline with a quiet zone
+    Bytes svg;
+    Grid grid;
+    uint32_t wrong;
+    if (qrcode_writeSVGOutline(qrcode, 2, 4, append_cb, &svg) || !svg_decode(std::string(svg.begin(), svg.end()), 2, &grid) ||
+        grid.width != size + 8 || grid.height != size + 8) {
+        wrong = 1 << 20;
+    } else {
+        wrong = compareGrid(grid, qrcode, 4, 4, size + 8, size + 8);
+    }
+    result(wrong, "SVG outline: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+
+    // Polylines, one closed "x,y x,y ..." outline per line, as a path
+    Bytes text;
+    std::string path;
+    wrong = qrcode_writePolylines(qrcode, append_cb, &text) ? 1 : 0;
+    for (size_t i = 0; i < text.size();) {
+        size_t end = i;
+        while (end < text.size() && text[end] != '\n') { end++; }
+
+        std::string line((const char *)text.data() + i, end - i);
+        int x0, y0, x1, y1, n;
+        if (sscanf(line.c_str(), "%d,%d%n", &x0, &y0, &n) != 2) { wrong++; }
+        path += "M" + std::to_string(x0) + " " + std::to_string(y0);
+        for (const char *p = line.c_str() + n; sscanf(p, " %d,%d%n", &x1, &y1, &n) == 2; p += n) {
+            path += "L" + std::to_string(x1) + " " + std::to_string(y1);
+        }
+        if (x1 != x0 || y1 != y0) { wrong++; }
+        i = end + 1;
+    }
+    grid.width = grid.height = size;
+    grid.dark.assign(size * size, 0);
+    if (!svg_fillPath(&grid, path, 0, 0)) { wrong++; }
+    result(wrong + compareGrid(grid, qrcode, 0, 0, size, size), "Polylines: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+
+    // G-code at 0.25mm per module with Y up; M3/M5 surround each outline
+    Bytes gcode;
+    bool on = false;
+    path.clear();
+    wrong = qrcode_writeGCode(qrcode, 250, 600, append_cb, &gcode) ? 1 : 0;
+    std::string program(gcode.begin(), gcode.end());
+    for (size_t i = 0; i < program.size();) {
+        size_t end = program.find('\n', i);
+        std::string line = program.substr(i, end - i);
+        double x, y;
+        i = end + 1;
+
+        if (line == "M3" || line == "M5") {
+            if (on && line == "M3") { wrong++; }
+            on = line == "M3";
+        } else if (sscanf(line.c_str(), "G%*d X%lf Y%lf", &x, &y) == 2) {
+            int mx = (int)(x * 4 + 0.5), my = size - (int)(y * 4 + 0.5);
+            if (line[1] == '0' && on) { wrong++; }
+            path += (line[1] == '0' ? "M" : "L") + std::to_string(mx) + " " + std::to_string(my);
+        }
+    }
+    grid.dark.assign(size * size, 0);
+    if (on || !svg_fillPath(&grid, path, 0, 0)) { wrong++; }
+    result(wrong + compareGrid(grid, qrcode, 0, 0, size, size), "G-code: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+}
+
+
+#pragma mark - PDF
+
+// Checks the xref offsets and stream lengths of a label sheet, then fills the rectangles of
+// each symbol XObject into a grid.
+static void testPDF() {
+    static const uint8_t versions[] = { 1, 5, 10, 2, 7, 3, 40 };
+    const uint8_t count = sizeof(versions), columns = 2, rows = 2;
+    QRCode qrcodes[count];
+    std::vector<Bytes> buffers(count);
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t version = LOCK_VERSION ? LOCK_VERSION : versions[i];
+        buffers[i].resize(qrcode_getBufferSize(version));
+        qrcode_initText(&qrcodes[i], buffers[i].data(), version, i % 4, "HELLO");
+    }
+
+    Bytes pdf, reused;
+    static QRCodeEncoder encoder;
+    if (qrcode_writePDF(qrcodes, count, columns, rows, 612, 792, 2, append_cb, &pdf) ||
+        qrcode_writePDFWithEncoder(qrcodes, count, columns, rows, 612, 792, 2, append_cb, &reused, &encoder)) {
+        result(1, "PDF: write");
+        return;
+    }
+    result(pdf != reused, "PDF: reused encoder");
+
+    std::string text(pdf.begin(), pdf.end());
+    result(text.compare(0, 9, "%PDF-1.4\n") != 0 || text.compare(text.size() - 6, 6, "%%EOF\n") != 0, "PDF: header and trailer");
+    result(text.find("/Type /Pages /Count 2 ") == std::string::npos, "PDF: page count");
+
+    // Every object listed in the xref table starts where it says...
+    size_t startxref = text.rfind("startxref\n");
+    uint32_t wrong = 0, objects = 0;
+    size_t xref = startxref == std::string::npos ? 0 : strtoul(text.c_str() + startxref + 10, NULL, 10);
+    if (xref == 0 || sscanf(text.c_str() + xref, "xref\n0 %u\n", &objects) != 1 || objects != 3 + 2 * 2 + count) {
+        wrong = 1 << 20;
+    } else {
+        const char *entry = strchr(text.c_str() + xref + 5, '\n') + 1 + 20;
+        for (uint32_t i = 1; i < objects; i++, entry += 20) {
+            char expected[32];
+            snprintf(expected, sizeof(expected), "%u 0 obj\n", i);
+            if (text.compare(strtoul(entry, NULL, 10), strlen(expected), expected) != 0) { wrong++; }
+        }
+    }
+    result(wrong, "PDF: xref");
+
+    // ...and every stream is as long as its /Length, holding a zlib stream
+    uint8_t symbol = 0;
+    for (size_t start = text.find(">>\nstream\n"); start != std::string::npos; start = text.find(">>\nstream\n", start + 1)) {
+        size_t dict = text.rfind("obj\n", start), length = text.rfind("/Length ", start);
+        size_t bbox = text.find("/BBox [0 0 ", dict);
+        size_t data = start + 10, bytes = strtoul(text.c_str() + length + 8, NULL, 10);
+        Bytes content;
+
+        if (length < dict || text.compare(data + bytes, 10, "\nendstream") != 0 || !zlib_inflate(pdf.data() + data, bytes, &content)) {
+            result(1, "PDF: stream at %u", (unsigned)start);
+            continue;
+        }
+        if (bbox > start) { continue; }
+
+        // Symbol XObjects are in the same order as the symbols
+        if (symbol >= count) {
+            result(1, "PDF: extra XObject");
+            break;
+        }
+
+        QRCode *qrcode = &qrcodes[symbol++];
+        int32_t size = qrcode->size;
+        Grid grid = { size, size, Bytes((size_t)(size * size)) };
+        std::string ops(content.begin(), content.end());
+        char expected[32];
+        int x, y, width, height, n;
+
+        snprintf(expected, sizeof(expected), "1 0 0 -1 0 %d cm\n", size);
+        wrong = ops.compare(0, strlen(expected), expected) != 0 || ops.compare(ops.size() - 2, 2, "f\n") != 0;
+        for (const char *op = ops.c_str() + strlen(expected); sscanf(op, "%d %d %d %d re\n%n", &x, &y, &width, &height, &n) == 4; op += n) {
+            for (int32_t j = y; j < y + height; j++) {
+                for (int32_t i = x; i < x + width; i++) {
+                    if (i < 0 || j < 0 || i >= size || j >= size) {
+                        wrong++;
+                    } else {
+                        grid.dark[(size_t)(j * size + i)] = 1;
+                    }
+                }
+            }
+        }
+        wrong += compareGrid(grid, qrcode, 0, 0, size, size);
+        result(wrong, "PDF: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+    }
+    result(symbol != count, "PDF: XObject count");
+}
+
+
+#pragma mark - EPS
+
+// Fills the "x y w R" and "x y w h B" rectangles into a grid of the whole image.
+static void testEPS(QRCode *qrcode) {
+    for (uint8_t border = 0; border <= 4; border += 4) {
+        Bytes eps;
+        int32_t units = qrcode->size + 2 * border;
+        uint32_t wrong = 0;
+
+        if (qrcode_writeEPS(qrcode, 2, border, append_cb, &eps)) {
+            result(1 << 20, "EPS: version=%d, ecc=%d, border=%d", qrcode->version, qrcode->ecc, border);
+            continue;
+        }
+
+        std::string text(eps.begin(), eps.end());
+        char expected[128];
+        snprintf(expected, sizeof(expected), "%%%%BoundingBox: 0 0 %d %d\n", units * 2, units * 2);
+        wrong += text.find(expected) == std::string::npos;
+        snprintf(expected, sizeof(expected), "\n%d %d translate 1 -1 scale\n", border, border + qrcode->size);
+        size_t start = text.find(expected);
+        wrong += start == std::string::npos || text.compare(text.size() - 24, 24, "grestore\nshowpage\n%%EOF\n") != 0;
+
+        Grid grid = { units, units, Bytes((size_t)(units * units)) };
+        const char *op = start == std::string::npos ? "" : text.c_str() + start + strlen(expected);
+        int x, y, width, height, n;
+        char name;
+        while (sscanf(op, "%d %d %d %n", &x, &y, &width, &n) == 3) {
+            op += n;
+            if (!strncmp(op, "R\n", 2)) {
+                height = 1;
+                n = 2;
+            } else if (sscanf(op, "%d %c\n%n", &height, &name, &n) != 2 || name != 'B') {
+                wrong++;
+                break;
+            }
+            for (int32_t j = y; j < y + height; j++) {
+                for (int32_t i = x; i < x + width; i++) {
+                    if (i < 0 || j < 0 || i >= qrcode->size || j >= qrcode->size) {
+                        wrong++;
+                    } else {
+                        grid.dark[(size_t)((j + border) * units + i + border)] = 1;
+                    }
+                }
+            }
+            op += n;
+        }
+        wrong += strncmp(op, "grestore\n", 9) != 0;
+        wrong += compareGrid(grid, qrcode, border, border, units, units);
+
+        result(wrong, "EPS: version=%d, ecc=%d, border=%d", qrcode->version, qrcode->ecc, border);
+    }
+}
+
+
+#pragma mark - TIFF
+
+typedef struct BitReader {
+    const uint8_t *data;
+    size_t length, bit;
+} BitReader;
+
+static int32_t bits_get(BitReader *in) {
+    if (in->bit >= in->length * 8) { return -1; }
+    int32_t bit = (in->data[in->bit / 8] >> (7 - in->bit % 8)) & 1;
+    in->bit++;
+    return bit;
+}
+
+// Reads one code from any of the tables, returning its run length or -1.
+static int32_t g4_getCode(BitReader *in, bool black) {
+    const G4Code *tables[3] = { black ? G4_BLACK_TERM : G4_WHITE_TERM, black ? G4_BLACK_MAKEUP : G4_WHITE_MAKEUP, G4_EXT_MAKEUP };
+    static const uint8_t counts[3] = { 64, 27, 13 };
+    static const int32_t bases[3] = { 0, 64, 1792 };
+    uint16_t code = 0;
+
+    for (uint8_t length = 1; length <= 13; length++) {
+        int32_t bit = bits_get(in);
+        if (bit < 0) { return -1; }
+        code = (uint16_t)((code << 1) | bit);
+        for (uint8_t t = 0; t < 3; t++) {
+            for (uint8_t i = 0; i < counts[t]; i++) {
+                if (tables[t][i].length == length && tables[t][i].code == code) { return bases[t] + i * (t ? 64 : 1); }
+            }
+        }
+    }
+    return -1;
+}
+
+// Reads makeup codes up to a terminating code.
+static int32_t g4_getRun(BitReader *in, bool black) {
+    int32_t total = 0, run;
+    do {
+        if ((run = g4_getCode(in, black)) < 0) { return -1; }
+        total += run;
+    } while (run >= 64);
+    return total;
+}
+
+// Decodes a T.6 image into one byte per pixel, 1 for black.
+static bool g4_decode(const uint8_t *data, size_t length, uint32_t width, uint32_t height, Bytes *pixels) {
+    BitReader in = { data, length, 0 };
+    std::vector<uint32_t> ref, cur;
+
+    pixels->assign((size_t)width * height, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        int32_t a0 = -1;
+        bool black = false;
+
+        cur.clear();
+        while (a0 < (int32_t)width) {
+            // b1 is the first change above a0 to the other color, b2 the next one
+            size_t k = 0;
+            while (k < ref.size() && ((int32_t)ref[k] <= a0 || (k & 1) != black)) { k++; }
+            uint32_t b1 = k < ref.size() ? ref[k] : width, b2 = k + 1 < ref.size() ? ref[k + 1] : width;
+
+            uint8_t zeros = 0;
+            int32_t bit;
+            while ((bit = bits_get(&in)) == 0 && zeros < 7) { zeros++; }
+            if (bit < 0) { return false; }
+
+            if (bit != 1) {
+                return false;
+            } else if (zeros == 3) {
+                // Pass
+                a0 = (int32_t)b2;
+            } else if (zeros == 2) {
+                // Horizontal
+                uint32_t start = a0 < 0 ? 0 : (uint32_t)a0;
+                int32_t run1 = g4_getRun(&in, black), run2 = g4_getRun(&in, !black);
+                if (run1 < 0 || run2 < 0) { return false; }
+                cur.push_back(start + (uint32_t)run1);
+                cur.push_back(start + (uint32_t)(run1 + run2));
+                a0 = (int32_t)cur.back();
+            } else if (zeros <= 5) {
+                // Vertical: "1", then 011/010, 000011/000010 and 0000011/0000010 for a1 one
+                // to three pixels right/left of b1
+                int32_t delta = zeros == 0 ? 0 : zeros == 1 ? 1 : zeros - 2;
+                if (delta > 0 && bits_get(&in) == 0) { delta = -delta; }
+                if ((int32_t)b1 + delta <= a0 || (int32_t)b1 + delta > (int32_t)width) { return false; }
+                cur.push_back((uint32_t)((int32_t)b1 + delta));
+                a0 = (int32_t)cur.back();
+                black = !black;
+            } else {
+                return false;
+            }
+        }
+
+        // Fill the row from its changes
+        for (size_t i = 0; i < cur.size(); i += 2) {
+            uint32_t end = i + 1 < cur.size() ? cur[i + 1] : width;
+            for (uint32_t x = cur[i]; x < end && x < width; x++) { (*pixels)[(size_t)y * width + x] = 1; }
+        }
+        ref = cur;
+    }
+
+    // End of facsimile block
+    for (uint8_t eol = 0; eol < 2; eol++) {
+        for (uint8_t i = 0; i < 12; i++) {
+            if (bits_get(&in) != (i == 11)) { return false; }
+        }
+    }
+    return (in.bit + 7) / 8 == length;
+}
+
+static uint32_t tiff_getEntry(const Bytes &tiff, uint16_t tag) {
+    uint32_t ifd = getUInt32LE(tiff.data() + 4);
+    uint16_t count = (uint16_t)(tiff[ifd] | tiff[ifd + 1] << 8);
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t *entry = tiff.data() + ifd + 2 + i * 12;
+        if ((entry[0] | entry[1] << 8) == tag) {
+            return (entry[2] | entry[3] << 8) == 3 ? (uint32_t)(entry[8] | entry[9] << 8) : getUInt32LE(entry + 8);
+        }
+    }
+    return 0xffffffff;
+}
+
+static void testTIFF(QRCode *qrcode) {
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t scale = 1; scale <= 3; scale += 2) {
+        for (uint8_t border = 0; border <= 2; border += 2) {
+            Bytes tiff, pixels;
+            uint32_t width = scale * (qrcode->size + 2 * border), wrong = 0;
+
+            if (qrcode_writeTIFF(qrcode, scale, border, append_cb, &tiff) || tiff.size() < 8 || memcmp(tiff.data(), "II*\0", 4) != 0 ||
+                tiff_getEntry(tiff, 256) != width || tiff_getEntry(tiff, 257) != width || tiff_getEntry(tiff, 259) != 4 ||
+                tiff_getEntry(tiff, 262) != 0 || tiff_getEntry(tiff, 273) + tiff_getEntry(tiff, 279) != tiff.size() ||
+                !g4_decode(tiff.data() + tiff_getEntry(tiff, 273), tiff_getEntry(tiff, 279), width, width, &pixels)) {
+                wrong = 1 << 20;
+            } else {
+                for (uint32_t y = 0; y < width; y++) {
+                    for (uint32_t x = 0; x < width; x++) {
+                        int32_t mx = (int32_t)(x / scale) - border, my = (int32_t)(y / scale) - border;
+                        bool dark = mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+                        if (pixels[(size_t)y * width + x] != dark) { wrong++; }
+                    }
+                }
+            }
+
+            result(wrong, "TIFF: version=%d, ecc=%d, scale=%d, border=%d", qrcode->version, qrcode->ecc, scale, border);
+        }
+    }
+}
+
+
+#pragma mark - Raw images
+
+// Renders into a buffer of garbage and reads every pixel back.
+static void testRawImages(QRCode *qrcode) {
+    static const char *names[] = { "PBM", "PGM", "BMP" };
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t format = QRCODE_IMAGE_PBM; format <= QRCODE_IMAGE_BMP; format++) {
+        for (uint8_t scale = 1; scale <= 3; scale += 2) {
+            for (uint8_t border = 0; border <= 4; border += 4) {
+                uint32_t width = scale * (qrcode->size + 2 * border), wrong = 0;
+                uint32_t size = qrcode_getImageSize(qrcode, format, scale, border);
+                Bytes image(size, 0xa5);
+                size_t header = 0, rowBytes = 0;
+                char expected[64];
+
+                if (format == QRCODE_IMAGE_BMP) {
+                    header = 62;
+                    rowBytes = (width + 31) / 32 * 4;
+                } else {
+                    header = (size_t)snprintf(expected, sizeof(expected), format == QRCODE_IMAGE_PBM ? "P4\n%u %u\n" : "P5\n%u %u\n255\n", width, width);
+                    rowBytes = format == QRCODE_IMAGE_PBM ? (width + 7) / 8 : width;
+                }
+
+                if (size != header + rowBytes * width || qrcode_renderImage(qrcode, format, scale, border, image.data(), size - 1) == 0 ||
+                    qrcode_renderImage(qrcode, format, scale, border, image.data(), size) != 0) {
+                    result(1 << 20, "%s: version=%d, ecc=%d, scale=%d, border=%d", names[format], qrcode->version, qrcode->ecc, scale, border);
+                    continue;
+                }
+
+                if (format == QRCODE_IMAGE_BMP) {
+                    wrong += image[0] != 'B' || image[1] != 'M' || getUInt32LE(&image[2]) != size || getUInt32LE(&image[10]) != header;
+                    wrong += getUInt32LE(&image[18]) != width || getUInt32LE(&image[22]) != width || image[28] != 1;
+                    wrong += getUInt32LE(&image[54]) != 0x00ffffff || getUInt32LE(&image[58]) != 0;
+                } else {
+                    wrong += memcmp(image.data(), expected, header) != 0;
+                }
+
+                for (uint32_t y = 0; y < width; y++) {
+                    // BMP rows are bottom-up
+                    const uint8_t *row = image.data() + header + (format == QRCODE_IMAGE_BMP ? width - 1 - y : y) * rowBytes;
+                    for (uint32_t x = 0; x < width; x++) {
+                        int32_t mx = (int32_t)(x / scale) - border, my = (int32_t)(y / scale) - border;
+                        bool dark = mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+                        bool pixel = format == QRCODE_IMAGE_PGM ? row[x] == 0 : (row[x / 8] >> (7 - x % 8)) & 1;
+                        if (pixel != dark || (format == QRCODE_IMAGE_PGM && row[x] != 0 && row[x] != 255)) { wrong++; }
+                    }
+                }
+
+                result(wrong, "%s: version=%d, ecc=%d, scale=%d, border=%d", names[format], qrcode->version, qrcode->ecc, scale, border);
+            }
+        }
+    }
+}
+
+
+#pragma mark - ESC/POS
+
+typedef struct Chunks {
+    Bytes data;
+    std::vector<size_t> ends;   // Offset after each callback
+} Chunks;
+
+static bool chunks_cb(void *ctx, const uint8_t *data, size_t length) {
+    Chunks *chunks = (Chunks *)ctx;
+    chunks->data.insert(chunks->data.end(), data, data + length);
+    chunks->ends.push_back(chunks->data.size());
+    return true;
+}
+
+// Decodes the raster or column commands into one byte per dot, checking that every band
+// fits the printer buffer and is passed to the callback as soon as it is complete.
+static bool escpos_decode(const Chunks &chunks, uint8_t mode, uint32_t width, Bytes *pixels) {
+    const Bytes &data = chunks.data;
+    size_t pos = 0, end = data.size();
+    uint32_t y = 0;
+
+    pixels->assign((size_t)width * width, 0);
+    if (mode == QRCODE_ESCPOS_COLUMN) {
+        if (data.size() < 5 || memcmp(data.data(), "\x1b" "3\x18", 3) != 0 || memcmp(data.data() + end - 2, "\x1b" "2", 2) != 0) { return false; }
+        pos = 3;
+        end -= 2;
+    }
+
+    while (pos < end) {
+        if (mode == QRCODE_ESCPOS_RASTER) {
+            if (end - pos < 8 || memcmp(data.data() + pos, "\x1dv0\0", 4) != 0) { return false; }
+            uint32_t rowBytes = data[pos + 4] | data[pos + 5] << 8, rows = data[pos + 6] | data[pos + 7] << 8;
+            if (rowBytes != (width + 7) / 8 || rows == 0 || y + rows > width || (rows > 1 && rowBytes * rows > 1024)) { return false; }
+
+            pos += 8;
+            if (end - pos < (size_t)rowBytes * rows) { return false; }
+            for (uint32_t r = 0; r < rows; r++, y++) {
+                for (uint32_t x = 0; x < rowBytes * 8; x++) {
+                    bool dot = (data[pos + r * rowBytes + x / 8] >> (7 - x % 8)) & 1;
+                    if (x < width) {
+                        (*pixels)[(size_t)y * width + x] = dot;
+                    } else if (dot) {
+                        return false;
+                    }
+                }
+            }
+            pos += (size_t)rowBytes * rows;
+        } else {
+            if (end - pos < 5 || memcmp(data.data() + pos, "\x1b*!", 3) != 0) { return false; }
+            uint32_t columns = data[pos + 3] | data[pos + 4] << 8;
+            if (columns != width) { return false; }
+
+            pos += 5;
+            if (end - pos < (size_t)columns * 3 + 1 || data[pos + columns * 3] != '\n') { return false; }
+            for (uint32_t x = 0; x < columns; x++) {
+                for (uint32_t i = 0; i < 24; i++) {
+                    bool dot = (data[pos + x * 3 + i / 8] >> (7 - i % 8)) & 1;
+                    if (y + i < width) {
+                        (*pixels)[(size_t)(y + i) * width + x] = dot;
+                    } else if (dot) {
+                        return false;
+                    }
+                }
+            }
+            pos += (size_t)columns * 3 + 1;
+            y += 24;
+        }
+
+        // The band ends a callback
+        if (std::find(chunks.ends.begin(), chunks.ends.end(), pos) == chunks.ends.end()) { return false; }
+    }
+
+    return y >= width;
+}
+
+static void testESCPOS(QRCode *qrcode) {
+    static const char *names[] = { "raster", "column" };
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t mode = QRCODE_ESCPOS_RASTER; mode <= QRCODE_ESCPOS_COLUMN; mode++) {
+        for (uint8_t scale = 1; scale <= 3; scale += 2) {
+            for (uint8_t border = 0; border <= 4; border += 4) {
+                Chunks chunks;
+                Bytes pixels;
+                uint32_t width = scale * (qrcode->size + 2 * border), wrong = 0;
+
+                if (qrcode_writeESCPOS(qrcode, mode, scale, border, chunks_cb, &chunks) || !escpos_decode(chunks, mode, width, &pixels)) {
+                    wrong = 1 << 20;
+                } else {
+                    for (uint32_t y = 0; y < width; y++) {
+                        for (uint32_t x = 0; x < width; x++) {
+                            int32_t mx = (int32_t)(x / scale) - border, my = (int32_t)(y / scale) - border;
+                            bool dark = mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+                            if (pixels[(size_t)y * width + x] != dark) { wrong++; }
+                        }
+                    }
+                }
+
+                result(wrong, "ESC/POS %s: version=%d, ecc=%d, scale=%d, border=%d", names[mode], qrcode->version, qrcode->ecc, scale, border);
+            }
+        }
+    }
+}
+
+
+#pragma mark - ZPL
+
+// Expands the ^GFA compressed hex into rows of hex digits, then into dots.
+static bool zpl_decode(const std::string &zpl, uint32_t width, Bytes *pixels) {
+    unsigned total, field, rowBytes;
+    int n = 0;
+
+    if (sscanf(zpl.c_str(), "^XA\n^FO0,0^GFA,%u,%u,%u,%n", &total, &field, &rowBytes, &n) != 3 || n == 0 ||
+        rowBytes != (width + 7) / 8 || total != rowBytes * width || field != total) {
+        return false;
+    }
+
+    size_t end = zpl.find("^FS\n^XZ\n", (size_t)n);
+    if (end == std::string::npos || end + 8 != zpl.size()) { return false; }
+
+    std::vector<std::string> rows;
+    std::string row;
+    uint32_t repeat = 0;
+    for (size_t i = (size_t)n; i < end; i++) {
+        char c = zpl[i];
+
+        if (c >= 'G' && c <= 'Y') {
+            repeat += (uint32_t)(c - 'F');
+        } else if (c >= 'g' && c <= 'z') {
+            repeat += (uint32_t)(c - 'f') * 20;
+        } else if (isxdigit((unsigned char)c) && !islower((unsigned char)c)) {
+            row.append(repeat ? repeat : 1, c);
+            repeat = 0;
+        } else if (c == ',' || c == '!') {
+            if (repeat || row.size() > rowBytes * 2) { return false; }
+            row.append(rowBytes * 2 - row.size(), c == ',' ? '0' : 'F');
+        } else if (c == ':') {
+            if (repeat || !row.empty() || rows.empty()) { return false; }
+            row = rows.back();
+        } else if (c != '\n') {
+            return false;
+        }
+
+        if (row.size() > rowBytes * 2) { return false; }
+        if (row.size() == rowBytes * 2) {
+            rows.push_back(row);
+            row.clear();
+        }
+    }
+    if (!row.empty() || repeat || rows.size() != width) { return false; }
+
+    pixels->assign((size_t)width * width, 0);
+    for (uint32_t y = 0; y < width; y++) {
+        for (uint32_t x = 0; x < rowBytes * 8; x++) {
+            char digit = rows[y][x / 4];
+            uint8_t value = (uint8_t)(digit <= '9' ? digit - '0' : digit - 'A' + 10);
+            bool dot = (value >> (3 - x % 4)) & 1;
+            if (x < width) {
+                (*pixels)[(size_t)y * width + x] = dot;
+            } else if (dot) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void testZPL(QRCode *qrcode) {
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t scale = 1; scale <= 8; scale += scale < 3 ? 2 : 5) {
+        for (uint8_t border = 0; border <= 4; border += 4) {
+            Bytes zpl, pixels;
+            uint32_t width = scale * (qrcode->size + 2 * border), wrong = 0;
+
+            if (qrcode_writeZPL(qrcode, scale, border, append_cb, &zpl) || !zpl_decode(std::string(zpl.begin(), zpl.end()), width, &pixels)) {
+                wrong = 1 << 20;
+            } else {
+                for (uint32_t y = 0; y < width; y++) {
+                    for (uint32_t x = 0; x < width; x++) {
+                        int32_t mx = (int32_t)(x / scale) - border, my = (int32_t)(y / scale) - border;
+                        bool dark = mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+                        if (pixels[(size_t)y * width + x] != dark) { wrong++; }
+                    }
+                }
+            }
+
+            result(wrong, "ZPL: version=%d, ecc=%d, scale=%d, border=%d", qrcode->version, qrcode->ecc, scale, border);
+        }
+    }
+}
+
+
+#pragma mark - Text
+
+// Reads the half blocks back into two rows of modules per line.
+static void testText(QRCode *qrcode) {
+    static const char *blocks[4] = { " ", "\xe2\x96\x84", "\xe2\x96\x80", "\xe2\x96\x88" };
+
+    for (uint8_t options = 0; options <= (QRCODE_TEXT_INVERT | QRCODE_TEXT_ANSI); options++) {
+        for (uint8_t border = 0; border <= 1; border++) {
+            Bytes text;
+            bool invert = options & QRCODE_TEXT_INVERT;
+            int32_t units = qrcode->size + 2 * border, lines = 0;
+            uint32_t wrong = 0;
+
+            if (qrcode_writeText(qrcode, options, border, append_cb, &text)) {
+                result(1 << 20, "Text: version=%d, ecc=%d, options=%d, border=%d", qrcode->version, qrcode->ecc, options, border);
+                continue;
+            }
+
+            std::string s(text.begin(), text.end());
+            for (size_t pos = 0; pos < s.size(); lines++) {
+                size_t end = s.find('\n', pos);
+                if (end == std::string::npos) {
+                    wrong++;
+                    break;
+                }
+
+                std::string line = s.substr(pos, end - pos);
+                if (options & QRCODE_TEXT_ANSI) {
+                    const char *color = invert ? "\033[97;40m" : "\033[30;107m";
+                    if (line.compare(0, strlen(color), color) != 0 || line.size() < strlen(color) + 4 || line.compare(line.size() - 4, 4, "\033[0m") != 0) {
+                        wrong++;
+                        break;
+                    }
+                    line = line.substr(strlen(color), line.size() - strlen(color) - 4);
+                }
+
+                size_t at = 0;
+                for (int32_t x = 0; x < units; x++) {
+                    uint8_t index = 0;
+                    while (index < 4 && line.compare(at, strlen(blocks[index]), blocks[index]) != 0) { index++; }
+                    if (index == 4) {
+                        wrong++;
+                        break;
+                    }
+                    at += strlen(blocks[index]);
+
+                    // Drawn modules are dark, or light when inverted; nothing is drawn below the
+                    // last row
+                    for (int32_t half = 0; half < 2; half++) {
+                        int32_t y = lines * 2 + half;
+                        bool dark = x >= border && y >= border && x < border + qrcode->size && y < border + qrcode->size &&
+                                    qrcode_getModule(qrcode, x - border, y - border);
+                        bool drawn = y < units && dark != invert;
+                        if ((bool)(index & (2 >> half)) != drawn) { wrong++; }
+                    }
+                }
+                if (at != line.size()) { wrong++; }
+                pos = end + 1;
+            }
+            if (lines != (units + 1) / 2) { wrong++; }
+
+            result(wrong, "Text: version=%d, ecc=%d, options=%d, border=%d", qrcode->version, qrcode->ecc, options, border);
+        }
+    }
+}
+
+
+#pragma mark - Frame buffers
+
+// Renders into a display of random pixels at offsets that clip each edge, and checks that
+// only the pixels under the symbol changed.
+static void testRenderPages(QRCode *qrcode) {
+    static const int16_t offsets[][2] = { { 0, 0 }, { -5, -3 }, { 3, 5 }, { 21, -11 }, { -9, 30 } };
+    const uint16_t width = 160, height = 100, pages = (height + 7) / 8;
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t scale = 1; scale <= 2; scale++) {
+        for (uint8_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+            const uint8_t border = 2;
+            int16_t ox = offsets[i][0], oy = offsets[i][1];
+            int32_t extent = scale * (qrcode->size + 2 * border);
+            Bytes buffer((size_t)width * pages), before;
+            uint32_t wrong = 0;
+
+            for (size_t j = 0; j < buffer.size(); j++) { buffer[j] = (uint8_t)(j * 2654435761u >> 24); }
+            before = buffer;
+
+            if (qrcode_renderPages(qrcode, scale, border, ox, oy, buffer.data(), width, height)) {
+                wrong = 1 << 20;
+            } else {
+                for (int32_t y = 0; y < pages * 8; y++) {
+                    for (int32_t x = 0; x < width; x++) {
+                        bool pixel = (buffer[(size_t)(y / 8) * width + x] >> (y % 8)) & 1;
+                        bool expected = (before[(size_t)(y / 8) * width + x] >> (y % 8)) & 1;
+                        if (x >= ox && y >= oy && x < ox + extent && y < oy + extent && y < height) {
+                            int32_t mx = (x - ox) / scale - border, my = (y - oy) / scale - border;
+                            expected = mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+                        }
+                        if (pixel != expected) { wrong++; }
+                    }
+                }
+            }
+
+            result(wrong, "Pages: version=%d, ecc=%d, scale=%d, x=%d, y=%d", qrcode->version, qrcode->ecc, scale, ox, oy);
+        }
+    }
+}
+
+
+static void testBlit(QRCode *qrcode) {
+    static const int16_t offsets[][2] = { { 0, 0 }, { -7, -2 }, { 5, 9 }, { 101, -13 } };
+    const uint16_t width = 150, height = 120;
+    const uint32_t fgs[2] = { 0xf800, 0xff102030 }, bgs[2] = { 0x07ff, 0xffe0d0c0 };
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t format = QRCODE_PIXEL_RGB565; format <= QRCODE_PIXEL_ARGB8888; format++) {
+        uint8_t bpp = format == QRCODE_PIXEL_RGB565 ? 2 : 4;
+        uint32_t stride = width * bpp + 12;
+
+        for (uint8_t scale = 1; scale <= 5; scale += scale < 3 ? 1 : 2) {
+            for (uint8_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+                int16_t ox = offsets[i][0], oy = offsets[i][1];
+                int32_t extent = scale * qrcode->size;
+                Bytes buffer((size_t)stride * height), before;
+                uint32_t wrong = 0;
+
+                for (size_t j = 0; j < buffer.size(); j++) { buffer[j] = (uint8_t)(j * 2654435761u >> 24); }
+                before = buffer;
+
+                if (qrcode_blit(qrcode, buffer.data(), stride, width, height, format, ox, oy, scale, fgs[format], bgs[format])) {
+                    wrong = 1 << 20;
+                } else {
+                    for (int32_t y = 0; y < height; y++) {
+                        // The padding after each line is left alone too
+                        wrong += memcmp(&buffer[(size_t)y * stride + width * bpp], &before[(size_t)y * stride + width * bpp], stride - width * bpp) != 0;
+
+                        for (int32_t x = 0; x < width; x++) {
+                            const uint8_t *pixel = &buffer[(size_t)y * stride + x * bpp];
+                            uint32_t value = 0, expected = 0;
+
+                            if (x >= ox && y >= oy && x < ox + extent && y < oy + extent) {
+                                int32_t mx = (x - ox) / scale, my = (y - oy) / scale;
+                                expected = modules[my * qrcode->size + mx] ? fgs[format] : bgs[format];
+                            } else if (bpp == 2) {
+                                uint16_t old;
+                                memcpy(&old, &before[(size_t)y * stride + x * bpp], 2);
+                                expected = old;
+                            } else {
+                                memcpy(&expected, &before[(size_t)y * stride + x * bpp], 4);
+                            }
+
+                            if (bpp == 2) {
+                                uint16_t value16;
+                                memcpy(&value16, pixel, 2);
+                                value = value16;
+                            } else {
+                                memcpy(&value, pixel, 4);
+                            }
+                            if (value != expected) { wrong++; }
+                        }
+                    }
+                }
+
+                result(wrong, "Blit: version=%d, ecc=%d, format=%d, scale=%d, x=%d, y=%d", qrcode->version, qrcode->ecc, format, scale, ox, oy);
+            }
+        }
+    }
+}
+
+
+#pragma mark - Bitmaps
+
+// Checks one packed row against the modules, including the padding bits.
+static uint32_t checkBitmapRow(QRCode *qrcode, const Bytes &modules, const uint8_t *row, uint32_t y, uint8_t scale, uint8_t border) {
+    uint32_t width = scale * (qrcode->size + 2 * border), wrong = 0;
+    int32_t my = (int32_t)(y / scale) - border;
+
+    for (uint32_t x = 0; x < (width + 7) / 8 * 8; x++) {
+        int32_t mx = (int32_t)(x / scale) - border;
+        bool dark = x < width && mx >= 0 && my >= 0 && mx < qrcode->size && my < qrcode->size && modules[my * qrcode->size + mx];
+        if ((bool)((row[x / 8] >> (7 - x % 8)) & 1) != dark) { wrong++; }
+    }
+    return wrong;
+}
+
+static void testRenderBitmap(QRCode *qrcode) {
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t scale = 1; scale <= 9; scale += scale < 3 ? 2 : 6) {
+        for (uint8_t border = 0; border <= 3; border += 3) {
+            uint32_t width = scale * (qrcode->size + 2 * border), rowBytes = (width + 7) / 8, stride = rowBytes + 3, wrong = 0;
+            Bytes row(rowBytes), bitmap((size_t)stride * width, 0x5a);
+
+            for (uint32_t y = 0; y < width; y++) {
+                wrong += qrcode_renderRow(qrcode, y, scale, border, row.data()) != 0;
+                wrong += checkBitmapRow(qrcode, modules, row.data(), y, scale, border);
+            }
+            wrong += qrcode_renderRow(qrcode, width, scale, border, row.data()) == 0;
+
+            wrong += qrcode_renderBitmap(qrcode, scale, border, bitmap.data(), stride) != 0;
+            for (uint32_t y = 0; y < width; y++) {
+                wrong += checkBitmapRow(qrcode, modules, &bitmap[(size_t)y * stride], y, scale, border);
+                for (uint32_t i = rowBytes; i < stride; i++) { wrong += bitmap[(size_t)y * stride + i] != 0x5a; }
+            }
+            wrong += qrcode_renderBitmap(qrcode, scale, border, bitmap.data(), rowBytes - 1) == 0;
+
+            result(wrong, "Bitmap: version=%d, ecc=%d, scale=%d, border=%d", qrcode->version, qrcode->ecc, scale, border);
+        }
+    }
+}
+
+// Reads the image in bands of different heights and compares each line with renderRow.
+static void testRaster(QRCode *qrcode) {
+    static const uint16_t bands[] = { 1, 7, 64 };
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t scale = 1; scale <= 3; scale += 2) {
+        for (uint8_t i = 0; i < sizeof(bands) / sizeof(bands[0]); i++) {
+            const uint8_t border = 4;
+            uint32_t width = scale * (qrcode->size + 2 * border), rowBytes = (width + 7) / 8, stride = rowBytes + 1, y = 0, wrong = 0;
+            Bytes band((size_t)stride * bands[i]);
+            QRCodeRaster raster;
+            uint16_t lines;
+
+            qrcode_rasterBegin(&raster, qrcode, scale, border);
+            while ((lines = qrcode_rasterNext(&raster, band.data(), stride, bands[i])) > 0) {
+                if (lines != bands[i] && y + lines != width) { wrong++; }
+                for (uint16_t line = 0; line < lines; line++, y++) {
+                    wrong += checkBitmapRow(qrcode, modules, &band[(size_t)line * stride], y, scale, border);
+                }
+            }
+            if (y != width) { wrong++; }
+
+            result(wrong, "Raster: version=%d, ecc=%d, scale=%d, band=%d", qrcode->version, qrcode->ecc, scale, bands[i]);
+        }
+    }
+}
+
+// Rows past 65535 of an image at the largest scale and quiet zone.
+static void testRenderRowTall() {
+    uint8_t version = LOCK_VERSION ? LOCK_VERSION : 40;
+    Bytes buffer(qrcode_getBufferSize(version));
+    QRCode qrcode;
+    qrcode_initText(&qrcode, buffer.data(), version, ECC_LOW, "HELLO");
+
+    Bytes modules = getModules(&qrcode);
+    const uint8_t scale = 255, border = 255;
+    uint32_t height = scale * (qrcode.size + 2 * border), wrong = 0;
+    Bytes row((height + 7) / 8);
+
+    for (uint32_t y = 65535 - scale; y < height; y += 1999) {
+        wrong += qrcode_renderRow(&qrcode, y, scale, border, row.data()) != 0;
+        wrong += checkBitmapRow(&qrcode, modules, row.data(), y, scale, border);
+    }
+    wrong += qrcode_renderRow(&qrcode, height, scale, border, row.data()) == 0;
+
+    result(wrong, "Bitmap: rows past 65535");
+}
+
+
+#pragma mark - Grayscale
+
+// Shades each pixel by brute force: the dark area under it, in units of 1/size module.
+static Bytes grayReference(QRCode *qrcode, const Bytes &modules, uint16_t size, uint8_t border) {
+    uint32_t n = qrcode->size + 2 * border, area = n * n;
+    Bytes pixels((size_t)size * size);
+
+    for (uint32_t py = 0; py < size; py++) {
+        for (uint32_t px = 0; px < size; px++) {
+            uint64_t dark = 0;
+            for (uint32_t my = py * n / size; my * size < (py + 1) * n && my < n; my++) {
+                uint32_t top = std::max(py * n, my * size), bottom = std::min((py + 1) * n, (my + 1) * size);
+                for (uint32_t mx = px * n / size; mx * size < (px + 1) * n && mx < n; mx++) {
+                    uint32_t left = std::max(px * n, mx * size), right = std::min((px + 1) * n, (mx + 1) * size);
+                    int32_t x = (int32_t)mx - border, y = (int32_t)my - border;
+                    if (x >= 0 && y >= 0 && x < qrcode->size && y < qrcode->size && modules[y * qrcode->size + x]) {
+                        dark += (uint64_t)(bottom - top) * (right - left);
+                    }
+                }
+            }
+            pixels[(size_t)py * size + px] = (uint8_t)(255 - (255 * dark + area / 2) / area);
+        }
+    }
+    return pixels;
+}
+
+static void testGray(QRCode *qrcode) {
+    static const uint16_t sizes[] = { 61, 100, 301 };
+    Bytes modules = getModules(qrcode);
+
+    for (uint8_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        const uint8_t border = 3;
+        uint16_t size = sizes[i];
+        uint32_t stride = size + 5, width, height, wrong = 0;
+        uint8_t depth;
+        Bytes expected = grayReference(qrcode, modules, size, border), buffer((size_t)stride * size), pgm, png, pixels;
+        char header[32];
+        size_t headerLength = (size_t)snprintf(header, sizeof(header), "P5\n%u %u\n255\n", size, size);
+
+        // The buffer, PGM and PNG all render the same pixels
+        if (qrcode_renderGray(qrcode, size, border, buffer.data(), stride) || qrcode_writePGM(qrcode, size, border, append_cb, &pgm) ||
+            qrcode_writeGrayPNG(qrcode, size, border, append_cb, &png) || !png_decode(png, &width, &height, &depth, &pixels) ||
+            width != size || height != size || depth != 8 || pgm.size() != headerLength + (size_t)size * size ||
+            memcmp(pgm.data(), header, headerLength) != 0) {
+            wrong = 1 << 20;
+        } else {
+            for (uint32_t y = 0; y < size; y++) {
+                wrong += memcmp(&buffer[(size_t)y * stride], &expected[(size_t)y * size], size) != 0;
+                wrong += memcmp(&pgm[headerLength + (size_t)y * size], &expected[(size_t)y * size], size) != 0;
+                wrong += memcmp(&pixels[(size_t)y * size], &expected[(size_t)y * size], size) != 0;
+            }
+        }
+
+        result(wrong, "Gray: version=%d, ecc=%d, size=%d", qrcode->version, qrcode->ecc, size);
+    }
+}
+
+
+#pragma mark - Hex and base64
+
+static int base64_value(char c) {
+    const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char *found = c ? strchr(alphabet, c) : NULL;
+    return found ? (int)(found - alphabet) : -1;
+}
+
+// Decodes padded base64; returns false on any bad character or length.
+static bool base64_decode(const std::string &text, Bytes *out) {
+    out->clear();
+    if (text.size() % 4 != 0) { return false; }
+
+    for (size_t i = 0; i < text.size(); i += 4) {
+        int values[4], pad = 0;
+        for (int j = 0; j < 4; j++) {
+            if (text[i + j] == '=' && i + 4 == text.size() && j >= 2) {
+                values[j] = 0;
+                pad++;
+            } else if (pad > 0 || (values[j] = base64_value(text[i + j])) < 0) {
+                return false;
+            }
+        }
+
+        uint32_t group = (uint32_t)(values[0] << 18 | values[1] << 12 | values[2] << 6 | values[3]);
+        out->push_back((uint8_t)(group >> 16));
+        if (pad < 2) { out->push_back((uint8_t)(group >> 8)); }
+        if (pad < 1) { out->push_back((uint8_t)group); }
+    }
+    return true;
+}
+
+// Both exports hold the modules packed row by row, most significant bit first, with the
+// bits after the last module cleared.
+static void testHexBase64(QRCode *qrcode) {
+    Bytes modules = getModules(qrcode), packed(((size_t)qrcode->size * qrcode->size + 7) / 8), decoded;
+    for (size_t i = 0; i < modules.size(); i++) {
+        if (modules[i]) { packed[i / 8] |= (uint8_t)(0x80 >> (i % 8)); }
+    }
+
+    std::string hex(qrcode_getHexLength(qrcode), '*'), base64(qrcode_getBase64Length(qrcode), '*');
+    qrcode_getHex(qrcode, &hex[0]);
+    qrcode_getBase64(qrcode, &base64[0]);
+
+    uint32_t wrong = hex.size() != packed.size() * 2 + 1 || hex.back() != '\0';
+    for (size_t i = 0; !wrong && i < packed.size(); i++) {
+        char digits[3];
+        snprintf(digits, sizeof(digits), "%02x", packed[i]);
+        wrong += hex.compare(i * 2, 2, digits) != 0;
+    }
+    result(wrong, "Hex: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+
+    wrong = base64.back() != '\0' || !base64_decode(base64.substr(0, base64.size() - 1), &decoded) || decoded != packed;
+    result(wrong, "Base64: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+}
+
+// The data URIs hold the same bytes as the PNG and SVG writers.
+static void testDataURI(QRCode *qrcode) {
+    static const char *prefixes[] = { "data:image/png;base64,", "data:image/svg+xml;base64," };
+
+    for (uint8_t format = QRCODE_URI_PNG; format <= QRCODE_URI_SVG; format++) {
+        Bytes image, uri, decoded;
+        uint32_t length = qrcode_getDataURILength(qrcode, format, 2, 4), wrong = 0;
+        std::string buffer(length, '*');
+
+        if (format == QRCODE_URI_PNG) {
+            wrong += qrcode_writePNG(qrcode, 2, 4, append_cb, &image) != 0;
+        } else {
+            wrong += qrcode_writeSVG(qrcode, 2, 4, append_cb, &image) != 0;
+        }
+        wrong += qrcode_writeDataURI(qrcode, format, 2, 4, append_cb, &uri) != 0;
+
+        std::string text(uri.begin(), uri.end());
+        size_t prefix = strlen(prefixes[format]);
+        wrong += text.compare(0, prefix, prefixes[format]) != 0 || !base64_decode(text.substr(prefix), &decoded) || decoded != image;
+
+        // The buffer version fits exactly in the reported length, and fails with one less
+        wrong += length != uri.size() + 1;
+        wrong += qrcode_getDataURI(qrcode, format, 2, 4, &buffer[0], length) != 0 || buffer != text + '\0';
+        wrong += qrcode_getDataURI(qrcode, format, 2, 4, &buffer[0], length - 1) == 0;
+
+        result(wrong, "Data URI: version=%d, ecc=%d, format=%d", qrcode->version, qrcode->ecc, format);
+    }
+}
+
+
+#pragma mark - Runs
+
+// Returns the index of the module "along" modules into row or column "line".
+static size_t runIndex(uint8_t direction, uint8_t size, uint8_t line, int32_t along) {
+    return direction == QRCODE_RUN_ROWS ? (size_t)line * size + along : (size_t)along * size + line;
+}
+
+// Rebuilds the symbol from its runs along the rows and down the columns; every run must
+// be maximal, and a cursor started part way down only sees the lines after its start.
+static void testRuns(QRCode *qrcode) {
+    Bytes modules = getModules(qrcode);
+    uint8_t size = qrcode->size;
+
+    for (uint8_t direction = QRCODE_RUN_ROWS; direction <= QRCODE_RUN_COLUMNS; direction++) {
+        for (uint8_t first = 0; first < size; first += size / 2 + 1) {
+            Bytes seen(modules.size());
+            QRCodeRunCursor cursor;
+            uint8_t x, length, previousLine = first, previousEnd = 0;
+            uint32_t wrong = 0;
+
+            qrcode_runBegin(&cursor, direction, first);
+            while (qrcode_nextRun(qrcode, &cursor, &x, &length)) {
+                // Runs come in order
+                uint8_t line = cursor.line;
+                if (line < first || line < previousLine || (line == previousLine && x < previousEnd) || length == 0 || x + length > size) {
+                    wrong++;
+                    break;
+                }
+
+                if (x > 0 && modules[runIndex(direction, size, line, x - 1)]) { wrong++; }
+                if (x + length < size && modules[runIndex(direction, size, line, x + length)]) { wrong++; }
+                for (uint8_t i = x; i < x + length; i++) { seen[runIndex(direction, size, line, i)]++; }
+
+                previousEnd = (uint8_t)(x + length);
+                previousLine = line;
+            }
+
+            for (uint8_t y = 0; y < size; y++) {
+                for (uint8_t i = 0; i < size; i++) {
+                    size_t index = (size_t)y * size + i;
+                    uint8_t line = direction == QRCODE_RUN_ROWS ? y : i;
+                    bool expected = line >= first && modules[index];
+                    if (seen[index] != expected) { wrong++; }
+                }
+            }
+
+            result(wrong, "Runs: version=%d, ecc=%d, direction=%d, first=%d", qrcode->version, qrcode->ecc, direction, first);
+        }
+    }
+}
+
+
+#pragma mark - Diff
+
+// Every changed module between two symbols is covered, and every rectangle holds a change.
+static void testDiff(QRCode *qrcode) {
+    Bytes buffer(qrcode_getBufferSize(qrcode->version));
+    QRCode other;
+
+    // The same version with other text, and the symbol against itself
+    qrcode_initText(&other, buffer.data(), qrcode->version, qrcode->ecc, "WORLD");
+
+    for (uint8_t same = 0; same <= 1; same++) {
+        QRCode *next = same ? qrcode : &other;
+        uint16_t count = qrcode_diff(qrcode, next, NULL, 0);
+        std::vector<QRCodeRect> rects(count + 1);
+        Bytes covered((size_t)qrcode->size * qrcode->size);
+        uint32_t wrong = qrcode_diff(qrcode, next, rects.data(), count) != count || (same && count != 0);
+
+        // A short array gets the first rectangles and the full count
+        if (count > 1) {
+            std::vector<QRCodeRect> part(1);
+            wrong += qrcode_diff(qrcode, next, part.data(), 1) != count || memcmp(&part[0], &rects[0], sizeof(QRCodeRect)) != 0;
+        }
+
+        for (uint16_t i = 0; i < count; i++) {
+            const QRCodeRect &rect = rects[i];
+            bool changed = false;
+
+            if (rect.width == 0 || rect.height == 0 || rect.x + rect.width > qrcode->size || rect.y + rect.height > qrcode->size) {
+                wrong++;
+                continue;
+            }
+            for (uint8_t y = rect.y; y < rect.y + rect.height; y++) {
+                for (uint8_t x = rect.x; x < rect.x + rect.width; x++) {
+                    covered[(size_t)y * qrcode->size + x] = 1;
+                    changed |= qrcode_getModule(qrcode, x, y) != qrcode_getModule(next, x, y);
+                }
+            }
+            if (!changed) { wrong++; }
+        }
+
+        for (uint8_t y = 0; y < qrcode->size; y++) {
+            for (uint8_t x = 0; x < qrcode->size; x++) {
+                if (qrcode_getModule(qrcode, x, y) != qrcode_getModule(next, x, y) && !covered[(size_t)y * qrcode->size + x]) { wrong++; }
+            }
+        }
+
+        result(wrong, "Diff: version=%d, ecc=%d, same=%d", qrcode->version, qrcode->ecc, same);
+    }
+}
+
+// Symbols of different sizes differ everywhere (a locked version has only one size).
+static void testDiffSizes() {
+    if (LOCK_VERSION != 0) { return; }
+
+    Bytes small(qrcode_getBufferSize(1)), large(qrcode_getBufferSize(2));
+    QRCode a, b;
+    QRCodeRect rect;
+
+    qrcode_initText(&a, small.data(), 1, ECC_LOW, "HELLO");
+    qrcode_initText(&b, large.data(), 2, ECC_LOW, "HELLO");
+
+    uint32_t wrong = qrcode_diff(&a, &b, &rect, 1) != 1 || rect.x != 0 || rect.y != 0 || rect.width != b.size || rect.height != b.size;
+    result(wrong, "Diff: different sizes");
+}
+
+
+#pragma mark - Row layouts
+
+// Every row copied as bytes or words, either bit order, matches the modules.
+static void testCopyRows(QRCode *qrcode) {
+    Bytes modules = getModules(qrcode);
+    uint8_t size = qrcode->size;
+
+    for (uint8_t options = 0; options < 4; options++) {
+        bool words = (options & QRCODE_ROWS_WORDS) != 0, lsbFirst = (options & QRCODE_ROWS_LSB_FIRST) != 0;
+        uint32_t stride = words ? (size + 31) / 32 * 4 + 4 : (size + 7) / 8 + 1;
+        std::vector<uint32_t> storage(((size_t)size * stride + 3) / 4 + 1, 0xa5a5a5a5);
+        uint8_t *rows = (uint8_t *)storage.data();
+        uint32_t wrong = qrcode_copyRows(qrcode, rows, stride, options) != 0;
+
+        for (uint8_t y = 0; y < size; y++) {
+            const uint8_t *row = rows + (size_t)y * stride;
+            for (uint8_t x = 0; x < size; x++) {
+                bool dark;
+                if (words) {
+                    uint32_t word;
+                    memcpy(&word, row + x / 32 * 4, 4);
+                    dark = (word >> (lsbFirst ? x % 32 : 31 - x % 32)) & 1;
+                } else {
+                    dark = (row[x / 8] >> (lsbFirst ? x % 8 : 7 - x % 8)) & 1;
+                }
+                if (dark != (modules[(size_t)y * size + x] != 0)) { wrong++; }
+            }
+        }
+
+        // A stride shorter than a row, or words that are not word aligned, is refused
+        wrong += qrcode_copyRows(qrcode, rows, words ? (size + 31) / 32 * 4 - 4 : (size + 7) / 8 - 1, options) != -1;
+        if (words) { wrong += qrcode_copyRows(qrcode, rows, stride + 1, options) != -1; }
+
+        result(wrong, "Copy rows: version=%d, ecc=%d, options=%d", qrcode->version, qrcode->ecc, options);
+    }
+}
+
+// A symbol with aligned rows has the same modules and renders exactly like the packed one.
+static void testAlignedRows(QRCode *qrcode) {
+    Bytes buffer(qrcode_getAlignedBufferSize(qrcode->version)), packed, aligned;
+    QRCode other;
+
+    uint32_t wrong = qrcode_initText(&other, buffer.data(), qrcode->version, qrcode->ecc | QRCODE_ALIGN_ROWS, "HELLO") != 0;
+    wrong += other.stride != (qrcode->size + 7) / 8 || other.ecc != qrcode->ecc;
+    wrong += getModules(&other) != getModules(qrcode);
+    wrong += qrcode_diff(qrcode, &other, NULL, 0) != 0;
+
+    qrcode_writePNG(qrcode, 3, 4, append_cb, &packed);
+    qrcode_writePNG(&other, 3, 4, append_cb, &aligned);
+    wrong += packed != aligned;
+
+    packed.clear();
+    aligned.clear();
+    qrcode_writeSVG(qrcode, 2, 4, append_cb, &packed);
+    qrcode_writeSVG(&other, 2, 4, append_cb, &aligned);
+    wrong += packed != aligned;
+
+    packed.clear();
+    aligned.clear();
+    qrcode_writeTIFF(qrcode, 2, 4, append_cb, &packed);
+    qrcode_writeTIFF(&other, 2, 4, append_cb, &aligned);
+    wrong += packed != aligned;
+
+    packed.clear();
+    aligned.clear();
+    qrcode_writeSVGOutline(qrcode, 2, 4, append_cb, &packed);
+    qrcode_writeSVGOutline(&other, 2, 4, append_cb, &aligned);
+    wrong += packed != aligned;
+
+    packed.clear();
+    aligned.clear();
+    qrcode_writeText(qrcode, 0, 2, append_cb, &packed);
+    qrcode_writeText(&other, 0, 2, append_cb, &aligned);
+    wrong += packed != aligned;
+
+    uint32_t length = qrcode_getImageSize(qrcode, QRCODE_IMAGE_BMP, 3, 1);
+    packed.assign(length, 0);
+    aligned.assign(length, 0);
+    qrcode_renderImage(qrcode, QRCODE_IMAGE_BMP, 3, 1, packed.data(), length);
+    qrcode_renderImage(&other, QRCODE_IMAGE_BMP, 3, 1, aligned.data(), length);
+    wrong += packed != aligned;
+
+    result(wrong, "Aligned rows: version=%d, ecc=%d", qrcode->version, qrcode->ecc);
+}
+
+
+#pragma mark - Transforms
+
+// Every transform moves each module where its definition says, in either row layout, and
+// the SVG of the result (whose patterns are no longer in place) matches the modules.
+static void testTransforms(QRCode *qrcode) {
+    static const uint8_t transforms[] = {
+        QRCODE_TRANSPOSE, QRCODE_MIRROR, QRCODE_FLIP, QRCODE_INVERT, QRCODE_ROTATE_90, QRCODE_ROTATE_180,
+        QRCODE_ROTATE_270, QRCODE_MIRROR | QRCODE_INVERT, QRCODE_TRANSPOSE | QRCODE_MIRROR | QRCODE_FLIP | QRCODE_INVERT
+    };
+    uint8_t size = qrcode->size;
+
+    for (size_t t = 0; t < sizeof(transforms); t++) {
+        uint8_t transform = transforms[t];
+        Bytes packed(qrcode_getBufferSize(qrcode->version)), aligned(qrcode_getAlignedBufferSize(qrcode->version)), svg;
+        QRCode moved, movedAligned;
+        QRCodeRectCursor cursor;
+        Grid grid;
+        uint32_t wrong = 0;
+
+        qrcode_initText(&moved, packed.data(), qrcode->version, qrcode->ecc, "HELLO");
+        qrcode_initText(&movedAligned, aligned.data(), qrcode->version, qrcode->ecc | QRCODE_ALIGN_ROWS, "HELLO");
+        qrcode_transform(&moved, transform);
+        qrcode_transform(&movedAligned, transform);
+
+        // Undo the transforms in reverse order to find where each module came from
+        for (uint8_t y = 0; y < size; y++) {
+            for (uint8_t x = 0; x < size; x++) {
+                uint8_t sx = x, sy = y;
+                if (transform & QRCODE_FLIP) { sy = size - 1 - sy; }
+                if (transform & QRCODE_MIRROR) { sx = size - 1 - sx; }
+                if (transform & QRCODE_TRANSPOSE) { std::swap(sx, sy); }
+
+                bool dark = qrcode_getModule(qrcode, sx, sy) != ((transform & QRCODE_INVERT) != 0);
+                if (qrcode_getModule(&moved, x, y) != dark || qrcode_getModule(&movedAligned, x, y) != dark) { wrong++; }
+            }
+        }
+
+        // The patterns stay in place for a transpose, so only then are they drawn separately
+        qrcode_rectsBegin(&moved, &cursor, QRCODE_COVER_DATA);
+        wrong += ((cursor.options & QRCODE_COVER_DATA) != 0) != (transform == QRCODE_TRANSPOSE);
+
+        if (qrcode_writeSVG(&moved, 3, 4, append_cb, &svg) || !svg_decode(std::string(svg.begin(), svg.end()), 3, &grid) ||
+            grid.width != size + 8 || grid.height != size + 8) {
+            wrong += 1 << 20;
+        } else {
+            wrong += compareGrid(grid, &moved, 4, 4, size + 8, size + 8);
+        }
+
+        result(wrong, "Transform: version=%d, ecc=%d, transform=%d", qrcode->version, qrcode->ecc, transform);
+    }
+}
+
+
+#pragma mark - Deflate helpers
+
+// Checks the checksums against published values, resumed, combined and over long runs.
+static void testChecksums() {
+    static const uint8_t digits[] = "123456789";
+    static const uint8_t wikipedia[] = "Wikipedia";
+
+    result(crc32_update(0, digits, 9) != 0xcbf43926, "CRC-32 of \"123456789\"");
+    result(crc32_update(crc32_update(0, digits, 4), digits + 4, 5) != 0xcbf43926, "CRC-32 resumed");
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t i = 0; i < 9; i++) { adler32_updateRun(&a, &b, wikipedia[i], 1); }
+    result(((b << 16) | a) != 0x11e60398, "Adler-32 of \"Wikipedia\"");
+
+    uint32_t a2 = 1, b2 = 0;
+    a = 1, b = 0;
+    for (uint8_t i = 0; i < 4; i++) { adler32_updateRun(&a, &b, wikipedia[i], 1); }
+    for (uint8_t i = 4; i < 9; i++) { adler32_updateRun(&a2, &b2, wikipedia[i], 1); }
+    adler32_combine(&a, &b, a2, b2, 5);
+    result(((b << 16) | a) != 0x11e60398, "Adler-32 combined");
+
+    // Long runs wrap the modulus several times
+    static uint8_t run[100000];
+    memset(run, 0xff, sizeof(run));
+    a = 1, b = 0;
+    adler32_updateRun(&a, &b, 0xff, sizeof(run));
+    result(((b << 16) | a) != adler32(run, sizeof(run)), "Adler-32 of a long run");
+}
+
+// Checks that the code lengths form a complete prefix code within the length limit, even
+// when the frequencies would give a much deeper tree.
+static void testHuffmanLengths() {
+    static const uint8_t limits[] = { 7, DEFLATE_MAX_BITS };
+
+    for (uint16_t count = 2; count <= DEFLATE_LITERALS; count++) {
+        for (uint8_t l = 0; l < sizeof(limits); l++) {
+            uint8_t maxBits = limits[l];
+            if (count > (1 << maxBits)) { continue; }
+
+            // Fibonacci frequencies give the deepest possible tree; reversed so they need sorting
+            uint32_t freq[DEFLATE_LITERALS], f0 = 1, f1 = 1;
+            uint8_t lengths[DEFLATE_LITERALS];
+            memset(freq, 0, sizeof(freq));
+            for (uint16_t i = 0; i < count; i++) {
+                freq[count - 1 - i] = f0;
+                uint32_t f2 = f0 + f1 > 0x0fffffff ? f1 : f0 + f1;
+                f0 = f1;
+                f1 = f2;
+            }
+
+            deflate_buildLengths(freq, count, maxBits, lengths);
+
+            uint32_t kraft = 0, wrong = 0;
+            for (uint16_t i = 0; i < count; i++) {
+                if (lengths[i] == 0 || lengths[i] > maxBits) {
+                    wrong++;
+                } else {
+                    kraft += 1 << (DEFLATE_MAX_BITS - lengths[i]);
+                }
+            }
+            result(wrong + (kraft != (1 << DEFLATE_MAX_BITS)), "Huffman lengths count=%u maxBits=%u", count, maxBits);
+        }
+    }
+}
+
+
+int main() {
+    testChecksums();
+    testHuffmanLengths();
+    forEachSymbol(testPNG);
+    forEachSymbol(testSVG);
+    testSVGSheet();
+    forEachSymbol(testCoverRects);
+    forEachSymbol(testContours);
+    forEachSymbol(testOutlines);
+    testPDF();
+    forEachSymbol(testEPS);
+    forEachSymbol(testTIFF);
+    forEachSymbol(testRawImages);
+    forEachSymbol(testESCPOS);
+    forEachSymbol(testZPL);
+    forEachSymbol(testText);
+    forEachSymbol(testRenderPages);
+    forEachSymbol(testBlit);
+    forEachSymbol(testRenderBitmap);
+    testRenderRowTall();
+    forEachSymbol(testRaster);
+    forEachSymbol(testGray);
+    forEachSymbol(testHexBase64);
+    forEachSymbol(testDataURI);
+    forEachSymbol(testRuns);
+    forEachSymbol(testDiff);
+    forEachSymbol(testCopyRows);
+    forEachSymbol(testAlignedRows);
+    forEachSymbol(testTransforms);
+    testDiffSizes();
+    testAlignmentPositions();
+
+    printf("Output tests complete: %d passed (out of %d)\n", passed, total);
+    return passed == total ? 0 : 1;
+}
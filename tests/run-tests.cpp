@@ -69,6 +69,12 @@ int main() {
                 totalRicMoo += std::clock() - t0;
 
                 uint32_t badModules = check(nayuki, &ricmoo);
+
+                // The same symbol with byte-aligned rows
+                QRCode aligned;
+                uint8_t alignedBytes[qrcode_getAlignedBufferSize(version)];
+                qrcode_initText(&aligned, alignedBytes, version, ecc | QRCODE_ALIGN_ROWS, data);
+                badModules += check(nayuki, &aligned);
                 if (badModules) {
                     printf("Failed test case: version=%d, ecc=%d, data=\"%s\", faliured=%d\n", version, ecc, data, badModules);
                 } else {
@@ -3,3 +3,5 @@
 clang++ run-tests.cpp QrCode.cpp QrSegment.cpp BitBuffer.cpp ../src/qrcode.c -o test && ./test
 clang++ run-tests.cpp QrCode.cpp QrSegment.cpp BitBuffer.cpp ../src/qrcode.c -o test -D LOCK_VERSION=3 && ./test
 
+clang++ run-output-tests.cpp ../src/qrcode.c -o test-output && ./test-output
+clang++ run-output-tests.cpp ../src/qrcode.c -o test-output -D LOCK_VERSION=3 && ./test-output